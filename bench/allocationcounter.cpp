@@ -0,0 +1,83 @@
+#include "allocationcounter.h"
+
+#include <stdlib.h>
+#include <new>
+
+static quint64 allocations = 0;
+
+#ifdef __GLIBC__
+
+// QByteArray and QString allocate with malloc/realloc inside QtCore, so
+// counting operator new alone would miss most of what matters here
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+}
+
+bool AllocationCounter::countsMalloc()
+{
+    return true;
+}
+
+#else
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) throw()
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) throw()
+{
+    free(ptr);
+}
+
+bool AllocationCounter::countsMalloc()
+{
+    return false;
+}
+
+#endif
+
+quint64 AllocationCounter::getAllocations()
+{
+    return allocations;
+}
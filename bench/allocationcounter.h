@@ -0,0 +1,15 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// Counts heap allocations made by the whole process, Qt included. On glibc
+// malloc itself is interposed; elsewhere only operator new is seen.
+class AllocationCounter
+{
+public:
+    static quint64 getAllocations();
+    static bool countsMalloc();
+};
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,73 @@
+TEMPLATE = app
+
+TARGET = wa-bench
+CONFIG += console
+CONFIG -= app_bundle
+
+QT += network
+QT -= gui
+
+# The codec is compiled in directly so the benchmark doesn't need the
+# axolotl libraries and measures exactly the sources in the tree
+SRCDIR = ../src
+INCLUDEPATH += $$SRCDIR
+
+HEADERS += \
+    allocationcounter.h \
+    memorydevice.h \
+    stanzas.h \
+    $$SRCDIR/attributelist.h \
+    $$SRCDIR/attributelistiterator.h \
+    $$SRCDIR/bintreenodereader.h \
+    $$SRCDIR/bintreenodewriter.h \
+    $$SRCDIR/receivebuffer.h \
+    $$SRCDIR/keystream.h \
+    $$SRCDIR/nibblecodec.h \
+    $$SRCDIR/payloadsink.h \
+    $$SRCDIR/protocoltreenode.h \
+    $$SRCDIR/protocoltreenodeview.h \
+    $$SRCDIR/protocoltreenodelist.h \
+    $$SRCDIR/protocoltreenodelistiterator.h \
+    $$SRCDIR/rc4.h \
+    $$SRCDIR/qtrfc2898.h \
+    $$SRCDIR/protocolexception.h \
+    $$SRCDIR/waexception.h \
+    $$SRCDIR/watokendictionary.h \
+    $$SRCDIR/watokendictionary_p.h \
+    $$SRCDIR/watokenids.h \
+    $$SRCDIR/walog.h \
+    $$SRCDIR/hmacsha1.h \
+    $$SRCDIR/sha1.h \
+    $$SRCDIR/sha1_p.h
+
+SOURCES += \
+    main.cpp \
+    allocationcounter.cpp \
+    memorydevice.cpp \
+    stanzas.cpp \
+    $$SRCDIR/attributelist.cpp \
+    $$SRCDIR/attributelistiterator.cpp \
+    $$SRCDIR/bintreenodereader.cpp \
+    $$SRCDIR/bintreenodewriter.cpp \
+    $$SRCDIR/receivebuffer.cpp \
+    $$SRCDIR/keystream.cpp \
+    $$SRCDIR/nibblecodec.cpp \
+    $$SRCDIR/payloadsink.cpp \
+    $$SRCDIR/protocoltreenode.cpp \
+    $$SRCDIR/protocoltreenodeview.cpp \
+    $$SRCDIR/protocoltreenodelist.cpp \
+    $$SRCDIR/protocoltreenodelistiterator.cpp \
+    $$SRCDIR/rc4.cpp \
+    $$SRCDIR/qtrfc2898.cpp \
+    $$SRCDIR/watokendictionary.cpp \
+    $$SRCDIR/walog.cpp \
+    $$SRCDIR/hmacsha1.cpp \
+    $$SRCDIR/sha1.cpp \
+    $$SRCDIR/sha1_x86.cpp
+
+lessThan(QT_MAJOR_VERSION, 5) {
+HEADERS += \
+    $$SRCDIR/qexception/qexception.h
+SOURCES += \
+    $$SRCDIR/qexception/qexception.cpp
+}
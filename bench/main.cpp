@@ -0,0 +1,240 @@
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "allocationcounter.h"
+#include "memorydevice.h"
+#include "stanzas.h"
+
+#include "bintreenodereader.h"
+#include "bintreenodewriter.h"
+#include "keystream.h"
+#include "sha1.h"
+#include "watokendictionary.h"
+
+struct Result
+{
+    int stanzas;
+    qint64 bytes;
+    qint64 nsecs;
+    quint64 allocations;
+    QVector<qint64> latencies;
+};
+
+enum Mode {
+    RoundTrip,      // encode, decode and build the ProtocolTreeNode
+    RoundTripView,  // encode and decode to a ProtocolTreeNodeView only
+    EncodeOnly      // writer only
+};
+
+// Writes the stanza and reads it back, iterations times. Every sample is
+// one full round trip: encode, (encrypt), frame, (decrypt), decode and
+// building the ProtocolTreeNode like WAConnection does, minus the parts
+// the mode leaves out.
+static bool roundTrip(const ProtocolTreeNode &node, bool encrypted, Mode mode,
+                      int iterations, Result &result)
+{
+    MemoryDevice device;
+    device.open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+
+    WATokenDictionary dict;
+    BinTreeNodeWriter writer(&device, &dict);
+    BinTreeNodeReader reader(&device, &dict);
+
+    KeyStream outputKey(QByteArray(20, 'k'), QByteArray(20, 'm'));
+    KeyStream inputKey(QByteArray(20, 'k'), QByteArray(20, 'm'));
+    if (encrypted) {
+        writer.setOutputKey(&outputKey);
+        writer.setCrypto(true);
+        reader.setInputKey(&inputKey);
+    }
+
+    // Warm up buffers and caches, then measure
+    int warmup = qMax(iterations / 10, 1);
+    result.latencies.clear();
+    result.latencies.reserve(iterations);
+
+    for (int i = 0; i < warmup + iterations; i++) {
+        if (i == warmup) {
+            result.stanzas = 0;
+            result.bytes = 0;
+            result.nsecs = 0;
+            result.allocations = AllocationCounter::getAllocations();
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        int bytes = writer.write(node);
+
+        if (mode == EncodeOnly) {
+            device.discard();
+        }
+        else {
+            ProtocolTreeNodeView view;
+            if (!reader.nextTree(view)) {
+                fprintf(stderr, "failed to read back %s\n", qPrintable(node.getTag()));
+                return false;
+            }
+            if (mode == RoundTrip) {
+                ProtocolTreeNode decoded;
+                view.materialize(decoded);
+            }
+        }
+
+        qint64 nsecs = timer.nsecsElapsed();
+        if (i >= warmup) {
+            result.stanzas++;
+            result.bytes += bytes;
+            result.nsecs += nsecs;
+            result.latencies.append(nsecs);
+        }
+    }
+
+    // Don't count the latency vector, it was reserved up front
+    result.allocations = AllocationCounter::getAllocations() - result.allocations;
+    return true;
+}
+
+static void report(const char *name, bool encrypted, Result &result)
+{
+    std::sort(result.latencies.begin(), result.latencies.end());
+    qint64 p50 = result.latencies.at(result.latencies.size() / 2);
+    qint64 p99 = result.latencies.at((result.latencies.size() * 99) / 100);
+
+    double seconds = result.nsecs / 1e9;
+    printf("%-10s %-6s %12.0f %10.2f %10.1f %8.2f %8.2f %10.0f\n",
+           name, encrypted ? "rc4" : "plain",
+           result.stanzas / seconds,
+           (result.bytes / (1024.0 * 1024.0)) / seconds,
+           (double) result.allocations / result.stanzas,
+           p50 / 1000.0, p99 / 1000.0,
+           (double) result.bytes / result.stanzas);
+}
+
+// Cross checks every SHA-1 backend the CPU supports against
+// QCryptographicHash, over all lengths around the block and padding
+// boundaries and fed in uneven pieces, then measures its throughput
+static bool sha1Backends()
+{
+    QByteArray data(64 * 1024, 0);
+    for (int i = 0; i < data.size(); i++)
+        data[i] = (char) (i * 131 + (i >> 8));
+
+    printf("%-10s %8s %12s %12s\n", "sha1", "check", "64 B MB/s", "64 KB MB/s");
+
+    bool ok = true;
+    for (int backend = 0; backend < Sha1::BackendCount; backend++) {
+        const char *name = Sha1::getBackendName((Sha1::Backend) backend);
+        if (!Sha1::setBackend((Sha1::Backend) backend)) {
+            printf("%-10s %8s\n", name, "n/a");
+            continue;
+        }
+
+        bool matches = true;
+        for (int length = 0; length <= 4 * SHA1_BLOCK_SIZE + 1 && matches; length++) {
+            QByteArray expected = QCryptographicHash::hash(data.left(length), QCryptographicHash::Sha1);
+            char digest[SHA1_DIGEST_SIZE];
+
+            Sha1::hash(data.constData(), length, digest);
+            matches = expected == QByteArray(digest, SHA1_DIGEST_SIZE);
+
+            Sha1 sha1;
+            for (int offset = 0, piece = 1; offset < length; offset += piece, piece += 7)
+                sha1.update(data.constData() + offset, qMin(piece, length - offset));
+            sha1.final(digest);
+            matches = matches && expected == QByteArray(digest, SHA1_DIGEST_SIZE);
+        }
+        if (!matches)
+            ok = false;
+
+        double rates[2];
+        int sizes[2] = { 64, data.size() };
+        for (int i = 0; i < 2; i++) {
+            char digest[SHA1_DIGEST_SIZE];
+            int count = (64 * 1024 * 1024) / sizes[i];
+            QElapsedTimer timer;
+            timer.start();
+            for (int j = 0; j < count; j++)
+                Sha1::hash(data.constData(), sizes[i], digest);
+            rates[i] = 64.0 / (timer.nsecsElapsed() / 1e9);
+        }
+
+        printf("%-10s %8s %12.0f %12.0f\n", name, matches ? "ok" : "FAILED", rates[0], rates[1]);
+    }
+
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int iterations = 20000;
+    Mode mode = RoundTrip;
+    QString only;
+    bool sha1 = false;
+
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size())
+            iterations = args[++i].toInt();
+        else if (args[i] == "--view")
+            mode = RoundTripView;
+        else if (args[i] == "--encode")
+            mode = EncodeOnly;
+        else if (args[i] == "-s" && i + 1 < args.size())
+            only = args[++i];
+        else if (args[i] == "--sha1")
+            sha1 = true;
+        else {
+            printf("usage: %s [-n iterations] [-s stanza] [--view | --encode | --sha1]\n"
+                   "  --view    decode to a ProtocolTreeNodeView only, don't build the tree\n"
+                   "  --encode  only measure the writer\n"
+                   "  --sha1    check the SHA-1 backends against QCryptographicHash\n",
+                   qPrintable(args[0]));
+            return 1;
+        }
+    }
+
+    if (sha1)
+        return sha1Backends() ? 0 : 1;
+
+    struct {
+        const char *name;
+        ProtocolTreeNode node;
+        int divisor;
+    } scenarios[] = {
+        { "message", Stanzas::message(), 1 },
+        { "receipt", Stanzas::receipt(), 1 },
+        { "presence", Stanzas::presence(), 1 },
+        { "prekeys", Stanzas::prekeys(), 50 },
+        { "groups", Stanzas::groups(), 50 }
+    };
+
+    if (!AllocationCounter::countsMalloc())
+        printf("note: only operator new is counted on this platform\n");
+    printf("%-10s %-6s %12s %10s %10s %8s %8s %10s\n",
+           "stanza", "crypto", "stanzas/s", "MB/s", "allocs", "p50 us", "p99 us", "bytes");
+
+    for (unsigned int i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (!only.isEmpty() && only != scenarios[i].name)
+            continue;
+
+        // The big iqs are a few KB each, fewer round trips are enough
+        int count = qMax(iterations / scenarios[i].divisor, 100);
+        for (int encrypted = 0; encrypted < 2; encrypted++) {
+            Result result;
+            if (!roundTrip(scenarios[i].node, encrypted, mode, count, result))
+                return 1;
+            report(scenarios[i].name, encrypted, result);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "memorydevice.h"
+
+#include <string.h>
+
+MemoryDevice::MemoryDevice(QObject *parent) : QIODevice(parent)
+{
+    readOffset = 0;
+    writeOffset = 0;
+}
+
+bool MemoryDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 MemoryDevice::bytesAvailable() const
+{
+    return (writeOffset - readOffset) + QIODevice::bytesAvailable();
+}
+
+void MemoryDevice::discard()
+{
+    readOffset = 0;
+    writeOffset = 0;
+}
+
+qint64 MemoryDevice::readData(char *data, qint64 maxSize)
+{
+    int bytes = (int) qMin(maxSize, (qint64) (writeOffset - readOffset));
+    memcpy(data, buffer.constData() + readOffset, bytes);
+    readOffset += bytes;
+
+    // Rewind instead of freeing, the device must not show up in the
+    // allocation counts
+    if (readOffset == writeOffset) {
+        readOffset = 0;
+        writeOffset = 0;
+    }
+    return bytes;
+}
+
+qint64 MemoryDevice::writeData(const char *data, qint64 maxSize)
+{
+    int bytes = (int) maxSize;
+    if (writeOffset + bytes > buffer.size())
+        buffer.resize(qMax(buffer.size() * 2, writeOffset + bytes));
+
+    memcpy(buffer.data() + writeOffset, data, bytes);
+    writeOffset += bytes;
+    return maxSize;
+}
@@ -0,0 +1,30 @@
+#ifndef MEMORYDEVICE_H
+#define MEMORYDEVICE_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+// In-memory pipe: everything written can be read back in order, like the
+// two ends of a socket
+class MemoryDevice : public QIODevice
+{
+public:
+    MemoryDevice(QObject *parent = 0);
+
+    bool isSequential() const;
+    qint64 bytesAvailable() const;
+
+    // Drops unread data, keeping the capacity
+    void discard();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+    QByteArray buffer;
+    int readOffset;
+    int writeOffset;
+};
+
+#endif // MEMORYDEVICE_H
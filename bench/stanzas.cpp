@@ -0,0 +1,114 @@
+#include "stanzas.h"
+
+static QByteArray bytes(int size, char seed)
+{
+    QByteArray result(size, '\0');
+    for (int i = 0; i < size; i++)
+        result[i] = (char) (seed + i * 31);
+    return result;
+}
+
+static QString phone(int i)
+{
+    return QString::number(34612000000LL + i * 7919) + "@s.whatsapp.net";
+}
+
+ProtocolTreeNode Stanzas::message()
+{
+    AttributeList attrs;
+    attrs.insert("from", phone(1));
+    attrs.insert("id", "1443434343-27");
+    attrs.insert("type", "text");
+    attrs.insert("t", "1443434343");
+    attrs.insert("notify", "Somebody");
+    ProtocolTreeNode messageNode("message", attrs);
+
+    ProtocolTreeNode bodyNode("body");
+    bodyNode.setData(QByteArray("Are we still on for tonight? I'll bring the charger you left here."));
+    messageNode.addChild(bodyNode);
+
+    return messageNode;
+}
+
+ProtocolTreeNode Stanzas::receipt()
+{
+    AttributeList attrs;
+    attrs.insert("from", phone(2));
+    attrs.insert("id", "1443434343-28");
+    attrs.insert("type", "read");
+    attrs.insert("t", "1443434350");
+    return ProtocolTreeNode("receipt", attrs);
+}
+
+ProtocolTreeNode Stanzas::presence()
+{
+    AttributeList attrs;
+    attrs.insert("from", phone(3));
+    attrs.insert("type", "unavailable");
+    attrs.insert("last", "1443434299");
+    return ProtocolTreeNode("presence", attrs);
+}
+
+ProtocolTreeNode Stanzas::prekeys(int count)
+{
+    AttributeList attrs;
+    attrs.insert("xmlns", "encrypt");
+    attrs.insert("to", "s.whatsapp.net");
+    attrs.insert("type", "set");
+    attrs.insert("id", "12");
+    ProtocolTreeNode iqNode("iq", attrs);
+
+    ProtocolTreeNode listNode("list");
+    for (int i = 0; i < count; i++) {
+        ProtocolTreeNode keyNode("key");
+        keyNode.addChild(ProtocolTreeNode("id", bytes(3, i)));
+        keyNode.addChild(ProtocolTreeNode("value", bytes(32, i + 1)));
+        listNode.addChild(keyNode);
+    }
+
+    ProtocolTreeNode skeyNode("skey");
+    skeyNode.addChild(ProtocolTreeNode("id", bytes(3, 7)));
+    skeyNode.addChild(ProtocolTreeNode("value", bytes(32, 8)));
+    skeyNode.addChild(ProtocolTreeNode("signature", bytes(64, 9)));
+
+    iqNode.addChild(ProtocolTreeNode("identity", bytes(32, 3)));
+    iqNode.addChild(listNode);
+    iqNode.addChild(ProtocolTreeNode("registration", bytes(4, 5)));
+    iqNode.addChild(ProtocolTreeNode("type", QByteArray(1, '\5')));
+    iqNode.addChild(skeyNode);
+
+    return iqNode;
+}
+
+ProtocolTreeNode Stanzas::groups(int count, int participants)
+{
+    AttributeList attrs;
+    attrs.insert("from", "g.us");
+    attrs.insert("type", "result");
+    attrs.insert("id", "13");
+    ProtocolTreeNode iqNode("iq", attrs);
+
+    ProtocolTreeNode groupsNode("groups");
+    for (int i = 0; i < count; i++) {
+        AttributeList groupAttrs;
+        groupAttrs.insert("id", QString::number(34612000000LL + i) + "-1443430000");
+        groupAttrs.insert("creator", phone(i));
+        groupAttrs.insert("creation", "1443430000");
+        groupAttrs.insert("subject", QString("Group number %1").arg(i));
+        groupAttrs.insert("s_t", "1443431000");
+        groupAttrs.insert("s_o", phone(i + 1));
+        ProtocolTreeNode groupNode("group", groupAttrs);
+
+        for (int j = 0; j < participants; j++) {
+            AttributeList participantAttrs;
+            participantAttrs.insert("jid", phone(i * participants + j));
+            if (j == 0)
+                participantAttrs.insert("type", "admin");
+            groupNode.addChild(ProtocolTreeNode("participant", participantAttrs));
+        }
+        groupsNode.addChild(groupNode);
+    }
+    iqNode.addChild(groupsNode);
+
+    return iqNode;
+}
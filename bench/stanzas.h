@@ -0,0 +1,18 @@
+#ifndef STANZAS_H
+#define STANZAS_H
+
+#include "protocoltreenode.h"
+
+// Representative stanzas, shaped like what the server and WAConnection
+// exchange in a busy session
+class Stanzas
+{
+public:
+    static ProtocolTreeNode message();
+    static ProtocolTreeNode receipt();
+    static ProtocolTreeNode presence();
+    static ProtocolTreeNode prekeys(int count = 200);
+    static ProtocolTreeNode groups(int count = 20, int participants = 20);
+};
+
+#endif // STANZAS_H
@@ -5,6 +5,11 @@
 
 LiteAxolotlStore::LiteAxolotlStore(const QString &connection)
 {
+    identityKeyStore = NULL;
+    preKeyStore = NULL;
+    sessionStore = NULL;
+    signedPreKeyStore = NULL;
+
     _db = QSqlDatabase::database(connection);
     if (_db.isOpen()) {
         qDebug() << "Axolotl active connection" << _db.databaseName();
@@ -15,6 +20,22 @@ LiteAxolotlStore::LiteAxolotlStore(const QString &connection)
     }
 }
 
+LiteAxolotlStore::~LiteAxolotlStore()
+{
+    delete identityKeyStore;
+    delete preKeyStore;
+    delete sessionStore;
+    delete signedPreKeyStore;
+
+    // Only drop connections this store added, every QSqlDatabase copy
+    // must be gone by then
+    if (!_connection.isEmpty() && _db.isValid()) {
+        _db.close();
+        _db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(_connection);
+    }
+}
+
 void LiteAxolotlStore::setDatabaseName(const QString &name)
 {
     if (!_db.isOpen()) {
@@ -13,6 +13,7 @@ class LiteAxolotlStore : public AxolotlStore
 {
 public:
     LiteAxolotlStore(const QString &connection);
+    ~LiteAxolotlStore();
     void setDatabaseName(const QString &name);
     void clear();
 
@@ -26,19 +26,26 @@
  * official policies, either expressed or implied, of the copyright holder.
  */
 
-#include <QDataStream>
+#include <QDebug>
 
 #include "attributelist.h"
 #include "bintreenodereader.h"
+#include "walog.h"
 
-#define READ_TIMEOUT 30000
-
-BinTreeNodeReader::BinTreeNodeReader(QTcpSocket *socket, WATokenDictionary *dict,
+BinTreeNodeReader::BinTreeNodeReader(QIODevice *socket, WATokenDictionary *dict,
                                      QObject *parent) : QObject(parent)
 {
     this->dict = dict;
     this->socket = socket;
 
+    payloadSink = NULL;
+    payloadThreshold = PAYLOADSINK_DEFAULT_THRESHOLD;
+    bytesStreamed = 0;
+    bytesBuffered = 0;
+
+    stanzaFiltered = false;
+    filteredStanzas = 0;
+
     reset();
 }
 
@@ -46,38 +53,29 @@ void BinTreeNodeReader::reset()
 {
     inputKey = NULL;
 
-    if (decodedStream.isOpen())
-        decodedStream.close();
-    rawBuffer.clear();
-    decodedBuffer.clear();
+    frameState = ReadingHeader;
+    frameFlags = 0;
+    frameSize = 0;
+    frameConsumed = 0;
+    waitingForData = false;
+
+    // Drops any buffered bytes but keeps the capacity for the next session
+    receiveBuffer.clear();
+    readBegin = readPos = readEnd = NULL;
 }
 
 bool BinTreeNodeReader::getOneToplevelStream()
 {
-    qint32 bufferSize = readRawInt24();
-    qint8 flags = (bufferSize & 0xf00000) >> 20;
-    bufferSize &= 0x0fffff;
-
-    if (!fillRawBuffer(bufferSize)) {
+    if (!fillRawBuffer()) {
         return false;
     }
 
     //qDebug() << "[[ " + readBuffer.toHex();
-    if (decodedStream.isOpen()) {
-        decodedStream.close();
-    }
-
-    if (decodeRawStream(flags, 0, bufferSize)) {
-        decodedStream.setBuffer(&decodedBuffer);
-        decodedStream.open(QIODevice::ReadOnly);
-    } else {
-        return false;
-    }
-    return true;
+    return decodeRawStream(frameFlags, 3, frameSize);
 }
 
 int BinTreeNodeReader::getOneToplevelStreamSize() {
-    return decodedBuffer.size()
+    return (readEnd - readBegin)
             + 3 //sizeof(Int24) - buffer size
             + 4; //offset size (encoded length size)
 }
@@ -87,45 +85,70 @@ bool BinTreeNodeReader::decodeRawStream(qint8 flags, qint32 offset, qint32 lengt
     if ((flags & 8) != 0)
     {
         if (length < 4) {
-            qDebug() << "Invalid length 0x" << QString::number(length,16);
+            WA_LOG(WALogNetwork, WALogError) << "Invalid length 0x" << QString::number(length,16);
             harakiri();
             return false;
         }
 
-        offset += 4;
         length -= 4;
-        if (!inputKey->decodeMessage(rawBuffer, offset - 4, offset, length)) {
-            qDebug() << "error decoding message";
+        if (!inputKey->decodeMessage(receiveBuffer.data() + offset, length)) {
+            WA_LOG(WALogNetwork, WALogError) << "error decoding message";
             harakiri();
             return false;
         }
-
-        decodedBuffer = rawBuffer.right(length);
-        //qDebug() << "<< " + decodedBuffer.toHex();
-    } else {
-        //copy as is
-        decodedBuffer = rawBuffer;
     }
-    rawBuffer.clear();
+
+    // Parse straight from the receive buffer, no intermediate copies
+    readBegin = readPos = receiveBuffer.constData() + offset;
+    readEnd = readBegin + length;
     return true;
 }
 
 bool BinTreeNodeReader::nextTree(ProtocolTreeNode& node)
 {
-    bool result;
+    ProtocolTreeNodeView view;
 
-    if (!getOneToplevelStream()) {
+    if (!nextTree(view)) {
         return false;
     }
 
-    node.setSize(getOneToplevelStreamSize());
+    view.materialize(node);
+    return true;
+}
+
+bool BinTreeNodeReader::nextTree(ProtocolTreeNodeView& view)
+{
+    bool result;
+    int node;
+
+    waitingForData = false;
+    do {
+        if (!getOneToplevelStream()) {
+            return false;
+        }
 
-    result = nextTreeInternal(node);
-    qDebug() << "read" << node.getSize() << node.toString() << "\n" << result;
+        index.reset(readBegin, getOneToplevelStreamSize());
+
+        stanzaFiltered = false;
+        result = nextTreeInternal(node);
+        if (result && stanzaFiltered)
+            filteredStanzas++;
+    } while (result && stanzaFiltered);
+
+    if (result)
+        streamPayloads();
+    view = result ? ProtocolTreeNodeView(&index, node) : ProtocolTreeNodeView();
+    WA_LOG(WALogProtocol, WALogDebug) << "read" << view.getSize()
+            << view.toProtocolTreeNode().toString(0, WALog::getDumpLimit()) << "\n" << result;
     return result;
 }
 
-bool BinTreeNodeReader::nextTreeInternal(ProtocolTreeNode& node)
+bool BinTreeNodeReader::isWaitingForData() const
+{
+    return waitingForData;
+}
+
+bool BinTreeNodeReader::nextTreeInternal(int& node)
 {
     quint8 b;
 
@@ -146,20 +169,27 @@ bool BinTreeNodeReader::nextTreeInternal(ProtocolTreeNode& node)
         qDebug() << "Failed readInt8" << b;
         return false;
     }
-    QByteArray tag;
+
+    node = index.addNode();
+
+    int tag;
     if (!readString(b, tag)) {
         qDebug() << "Failed readString" << b;
         return false;
     }
-    int attribCount = (size - 2 + size % 2) / 2;
+    index.nodes[node].tag = tag;
 
-    AttributeList attribs;
-    if (!readAttributes(attribs,attribCount)) {
+    int attribCount = (size - 2 + size % 2) / 2;
+    if (!readAttributes(node, attribCount)) {
         qDebug() << "Failed readAttributes" << attribCount;
         return false;
     }
-    node.setTag(tag);
-    node.setAttributes(attribs);
+
+    // The frame length is already known, so the rest can just be dropped
+    if (node == 0 && isFiltered(node)) {
+        stanzaFiltered = true;
+        return true;
+    }
 
     if ((size % 2) == 1)
         return true;
@@ -173,12 +203,12 @@ bool BinTreeNodeReader::nextTreeInternal(ProtocolTreeNode& node)
         return readList(b, node);
     }
 
-    QByteArray data;
+    int data;
     if (!readString(b, data)) {
         qDebug() << "Failed readString" << b;
         return false;
     }
-    node.setData(data);
+    index.nodes[node].data = data;
     return true;
 }
 
@@ -187,30 +217,39 @@ bool BinTreeNodeReader::isListTag(quint32 b)
     return (b == 248) || (b == 0) || (b == 249);
 }
 
-bool BinTreeNodeReader::readList(qint32 token, ProtocolTreeNode& node)
+bool BinTreeNodeReader::readList(qint32 token, int node)
 {
     int size = 0;
     if (!readListSize(token, size)) {
         qDebug() << "failed to read listSize";
         return false;
     }
+
+    int previous = -1;
     for (int i = 0; i < size; i++)
     {
-        ProtocolTreeNode child;
-        //TODO: check results
-        nextTreeInternal(child);
-        node.addChild(child);
+        int child;
+        if (!nextTreeInternal(child))
+            return false;
+
+        if (previous < 0)
+            index.nodes[node].firstChild = child;
+        else
+            index.nodes[previous].next = child;
+        previous = child;
     }
+    index.nodes[node].childCount = size;
     return true;
 }
 
-bool BinTreeNodeReader::readAttributes(AttributeList& attribs, int attribCount)
+bool BinTreeNodeReader::readAttributes(int node, int attribCount)
 {
-    QByteArray key, value;
+    ProtocolTreeNodeIndex::Attribute attribute;
     for (int i=0; i < attribCount; i++)
     {
-        if (readString(key) && readString(value)) {
-            attribs.insert(QString::fromUtf8(key), QString::fromUtf8(value));
+        if (readString(attribute.key) && readString(attribute.value)) {
+            index.attributes.append(attribute);
+            index.nodes[node].attributeCount++;
         } else {
             qDebug() << "failed to read attribute key:value";
             //TODO: return false;
@@ -246,61 +285,65 @@ bool BinTreeNodeReader::readListSize(qint32 token, int& size)
     return true;
 }
 
-bool BinTreeNodeReader::fillRawBuffer(quint32 stanzaSize)
-{
-    return fillArrayFromRawStream(rawBuffer, stanzaSize);
-}
-
-bool BinTreeNodeReader::fillArray(QByteArray& buffer, quint32 len)
+bool BinTreeNodeReader::skipArray(quint32 len)
 {
-    buffer = decodedStream.read(len);
-    return buffer.size() == len;
+    if (len > (quint32)(readEnd - readPos)) {
+        return false;
+    }
+    readPos += len;
+    return true;
 }
 
-bool BinTreeNodeReader::fillArrayFromRawStream(QByteArray& buffer, quint32 len)
+bool BinTreeNodeReader::fillRawBuffer()
 {
-    char data[1025];
+    // The previous frame (and any slice of it) is released here
+    receiveBuffer.consume(frameConsumed);
+    frameConsumed = 0;
 
-    buffer.clear();
-    buffer.reserve(len);
+    if (frameState == ReadingHeader) {
+        if (!readSocket(3))
+            return false;
 
-    bool ready = true;
+        const uchar *header = reinterpret_cast<const uchar*>(receiveBuffer.constData());
+        qint32 bufferSize = (header[0] << 16) + (header[1] << 8) + header[2];
+        frameFlags = (bufferSize & 0xf00000) >> 20;
+        frameSize = bufferSize & 0x0fffff;
 
-    if (socket->bytesAvailable() < 1)
-    {
-        ready = socket->waitForReadyRead(-1);
+        if (!receiveBuffer.reserve(3 + frameSize)) {
+            WA_LOG(WALogNetwork, WALogError) << "Frame of" << frameSize << "bytes exceeds the receive buffer limit"
+                     << receiveBuffer.getLimit();
+            harakiri();
+            return false;
+        }
+        frameState = ReadingBody;
     }
 
-    if (!ready)
-    {
-        qDebug() << "fillArray() not ready / timed out";
-        harakiri();
+    if (!readSocket(3 + frameSize))
         return false;
-    }
 
-    int needToRead = len;
-    while (needToRead > 0)
-    {
-        int bytesRead = socket->read(data,(needToRead > 1024) ? 1024 : needToRead);
+    frameState = ReadingHeader;
+    frameConsumed = 3 + frameSize;
+    return true;
+}
 
+bool BinTreeNodeReader::readSocket(int needed)
+{
+    while (receiveBuffer.size() < needed) {
+        qint64 bytesRead = receiveBuffer.readFrom(socket);
         if (bytesRead < 0) {
-            qDebug() << "bytesRead < 0" << socket->errorString();
+            WA_LOG(WALogNetwork, WALogError) << "bytesRead < 0" << socket->errorString();
             harakiri();
             return false;
         }
         if (bytesRead == 0) {
-            socket->waitForReadyRead(-1);
-        }
-        else
-        {
-            needToRead -= bytesRead;
-            buffer.append(data, bytesRead);
+            waitingForData = true;
+            return false;
         }
     }
     return true;
 }
 
-bool BinTreeNodeReader::readString(QByteArray& s)
+bool BinTreeNodeReader::readString(int& s)
 {
     quint8 token;
     if (!readInt8(token)) {
@@ -310,7 +353,7 @@ bool BinTreeNodeReader::readString(QByteArray& s)
     return readString(token, s);
 }
 
-bool BinTreeNodeReader::readString(int token, QByteArray& s)
+bool BinTreeNodeReader::readString(int token, int& s)
 {
     if (token == -1) {
         qDebug() << "-1 token in readString";
@@ -330,13 +373,15 @@ bool BinTreeNodeReader::readString(int token, QByteArray& s)
             quint8 size8;
             if (!readInt8(size8))
                 return false;
-            return fillArray(s, size8);
+            s = index.addString(ProtocolTreeNodeIndex::RawString, readPos - readBegin, size8);
+            return skipArray(size8);
         }
         case 0xfd: {
             qint32 size24;
             if (!readInt24(size24))
                 return false;
-            return fillArray(s, size24);
+            s = index.addString(ProtocolTreeNodeIndex::RawString, readPos - readBegin, size24);
+            return skipArray(size24);
         }
         case 0xfe: {
             quint8 token8;
@@ -345,17 +390,12 @@ bool BinTreeNodeReader::readString(int token, QByteArray& s)
             return getToken(0xf5 + token8, s);
         }
         case 0xfa: {
-            QByteArray user,server;
+            int user, server;
             bool usr = readString(user);
             bool srv = readString(server);
-            if (usr && srv)
-            {
-                s = user + "@" + server;
-                return true;
-            }
             if (srv)
             {
-                s = server;
+                s = index.addString(ProtocolTreeNodeIndex::JidString, usr ? user : -1, server);
                 return true;
             }
             qDebug() << "readString couldn't reconstruct jid.";
@@ -367,15 +407,16 @@ bool BinTreeNodeReader::readString(int token, QByteArray& s)
             if (!readInt8(nbyte))
                 return false;
             int size = nbyte & 0x7f;
+            if (size == 0 && (nbyte & 0x80)) {
+                // An odd count of zero bytes would be -1 nibbles
+                qDebug() << "readString invalid nibble size" << QString::number(nbyte);
+                harakiri();
+                return false;
+            }
             int numnibbles = size * 2 - ((nbyte & 0x80) ? 1 : 0);
 
-            QByteArray res;
-            if (!fillArray(res, size))
-                return false;
-            res = res.toHex().left(numnibbles);
-            res = res.replace('a', '-').replace('b', '.');
-            s = res;
-            return true;
+            s = index.addString(ProtocolTreeNodeIndex::NibbleString, readPos - readBegin, numnibbles);
+            return skipArray(size);
         }
     }
     qDebug() << "readString invalid token" << QString::number(token);
@@ -383,23 +424,21 @@ bool BinTreeNodeReader::readString(int token, QByteArray& s)
     return false;
 }
 
-bool BinTreeNodeReader::getToken(int token, QByteArray &s)
+bool BinTreeNodeReader::getToken(int token, int &s)
 {
-    bool subdict = false;
-    QString string;
-    dict->getToken(string, subdict, token);
-    if (string.isEmpty()) {
+    // Tokens past the primary list select the secondary one and the actual
+    // index follows in the next byte
+    bool subdict = token >= WATOKEN_PRIMARY_COUNT && token < WATOKEN_COUNT;
+    int id = WATokenDictionary::tokenId(token, subdict);
+    if (id < 0) {
         quint8 ext;
         if (!readInt8(ext))
             return false;
-        dict->getToken(string, subdict, ext);
-        if (!string.isEmpty()) {
-            s = string.toUtf8();
-            return true;
-        }
+        id = WATokenDictionary::tokenId(ext, subdict);
     }
-    else {
-        s = string.toUtf8();
+
+    if (id >= 0) {
+        s = index.addString(ProtocolTreeNodeIndex::TokenString, id, 0);
         return true;
     }
 
@@ -408,70 +447,81 @@ bool BinTreeNodeReader::getToken(int token, QByteArray &s)
     return false;
 }
 
-bool BinTreeNodeReader::readInt8(quint8 &byte)
+void BinTreeNodeReader::streamPayloads()
 {
-    if (decodedStream.read(reinterpret_cast<char*>(&byte), 1) != 1) {
-        return false;
+    for (int i = 0; i < index.nodes.size(); i++) {
+        ProtocolTreeNodeIndex::Node &node = index.nodes[i];
+        if (node.data < 0)
+            continue;
+
+        const ProtocolTreeNodeIndex::String &s = index.strings.at(node.data);
+        if (s.type != ProtocolTreeNodeIndex::RawString)
+            continue;
+
+        if (payloadSink && s.b >= payloadThreshold
+                && payloadSink->begin(ProtocolTreeNodeView(&index, i), s.b)) {
+            payloadSink->write(index.frame + s.a, s.b);
+            payloadSink->end();
+            node.dataStreamed = true;
+            bytesStreamed += s.b;
+        }
+        else {
+            bytesBuffered += s.b;
+        }
     }
-    return true;
 }
 
-
-qint32 BinTreeNodeReader::readRawInt16()
+bool BinTreeNodeReader::isFiltered(int node)
 {
-    char buffer[2];
-
-    QByteArray readBytes(buffer, 2);
-
-    fillArrayFromRawStream(readBytes, 2);
-
-    qint32 result = (((quint8)readBytes.at(0)) << 8) + (quint8)readBytes.at(1);
+    if (stanzaFilters.isEmpty())
+        return false;
 
-    return (result);
+    ProtocolTreeNodeView view(&index, node);
+    int tag = view.getTagToken();
+    for (int i = 0; i < stanzaFilters.size(); i++) {
+        const StanzaFilter &filter = stanzaFilters.at(i);
+        if (filter.tag != tag)
+            continue;
+        if (filter.attribute < 0)
+            return true;
+        if (filter.value < 0 ? view.hasAttribute(filter.attribute)
+                             : view.attributeEquals(filter.attribute, filter.value))
+            return true;
+    }
+    return false;
 }
 
-qint32 BinTreeNodeReader::readRawInt24()
+bool BinTreeNodeReader::readInt8(quint8 &byte)
 {
-    char buffer[3];
-
-    QByteArray readBytes(buffer, 3);
-
-    fillArrayFromRawStream(readBytes, 3);
-
-    qint32 result = ((((quint8)readBytes.at(0)) << 16) + ((quint8)readBytes.at(1) << 8) +
-                     ((quint8)readBytes.at(2)));
-
-    return (result);
+    if (readPos >= readEnd) {
+        return false;
+    }
+    byte = (quint8)*readPos++;
+    return true;
 }
 
 
 bool BinTreeNodeReader::readInt16(qint16 &val)
 {
-    quint8 r1;
-    quint8 r2;
-
-    if (!readInt8(r1)
-            || !readInt8(r2)) {
+    if (readEnd - readPos < 2) {
         return false;
     }
 
-    val = (r1 << 8) + r2;
+    const uchar *p = reinterpret_cast<const uchar*>(readPos);
+    val = (p[0] << 8) + p[1];
+    readPos += 2;
     return true;
 }
 
 bool BinTreeNodeReader::readInt24(qint32 &val)
 {
-    quint8 r1;
-    quint8 r2;
-    quint8 r3;
-
-    if (!readInt8(r1)
-            || !readInt8(r2)
-            || !readInt8(r3)) {
+    if (readEnd - readPos < 3) {
         return false;
     }
 
-    val = (r1 << 16) + (r2 << 8) + r3;
+    const uchar *p = reinterpret_cast<const uchar*>(readPos);
+    val = (p[0] << 16) + (p[1] << 8) + p[2];
+    readPos += 3;
     return true;
 }
 
@@ -480,10 +530,59 @@ void BinTreeNodeReader::setInputKey(KeyStream *inputKey)
     this->inputKey = inputKey;
 }
 
+void BinTreeNodeReader::setReceiveBufferLimit(int limit)
+{
+    receiveBuffer.setLimit(limit);
+}
+
+const ReceiveBuffer &BinTreeNodeReader::getReceiveBuffer() const
+{
+    return receiveBuffer;
+}
+
+void BinTreeNodeReader::setPayloadSink(PayloadSink *sink, int threshold)
+{
+    payloadSink = sink;
+    payloadThreshold = threshold;
+}
+
+qint64 BinTreeNodeReader::getBytesStreamed() const
+{
+    return bytesStreamed;
+}
+
+qint64 BinTreeNodeReader::getBytesBuffered() const
+{
+    return bytesBuffered;
+}
+
+void BinTreeNodeReader::addStanzaFilter(int tag, int attribute, int value)
+{
+    StanzaFilter filter;
+    filter.tag = tag;
+    filter.attribute = attribute;
+    filter.value = value;
+    stanzaFilters.append(filter);
+}
+
+void BinTreeNodeReader::clearStanzaFilters()
+{
+    stanzaFilters.clear();
+}
+
+int BinTreeNodeReader::getFilteredStanzas() const
+{
+    return filteredStanzas;
+}
+
 void BinTreeNodeReader::harakiri()
 {
     QObject::disconnect(socket, 0, 0, 0);
-    socket->disconnectFromHost();
+    QAbstractSocket *tcpSocket = qobject_cast<QAbstractSocket*>(socket);
+    if (tcpSocket)
+        tcpSocket->disconnectFromHost();
+    else
+        socket->close();
     Q_EMIT socketBroken();
 }
 
@@ -29,15 +29,16 @@
 #ifndef BINTREENODEREADER_H
 #define BINTREENODEREADER_H
 
-#include <QDataStream>
-#include <QBuffer>
 #include <QStringList>
 #include <QTcpSocket>
 
 #include "keystream.h"
 #include "attributelist.h"
+#include "payloadsink.h"
 #include "protocoltreenode.h"
+#include "protocoltreenodeview.h"
 #include "protocoltreenodelist.h"
+#include "receivebuffer.h"
 #include "watokendictionary.h"
 
 class BinTreeNodeReader : public QObject
@@ -45,23 +46,83 @@ class BinTreeNodeReader : public QObject
     Q_OBJECT
 
 public:
-    BinTreeNodeReader(QTcpSocket *socket, WATokenDictionary *dict,
+    // socket is usually a QTcpSocket, any sequential device works
+    BinTreeNodeReader(QIODevice *socket, WATokenDictionary *dict,
                       QObject *parent = 0);
 
     void reset();
 
+    // Decodes the next complete stanza from whatever the socket has buffered.
+    // Never blocks: returns false when no complete frame is available yet,
+    // keeping any partial header/body until the next readyRead().
     bool nextTree(ProtocolTreeNode& node);
 
+    // Same as above without building the tree. The view indexes the frame
+    // in place and is only valid until the next call to nextTree().
+    bool nextTree(ProtocolTreeNodeView& view);
+
+    // True when the last nextTree() failed only because the rest of the
+    // frame hasn't arrived yet. Otherwise a frame was consumed but didn't
+    // decode, and the frames buffered after it can still be read.
+    bool isWaitingForData() const;
+
     void setInputKey(KeyStream *inputKey);
 
+    void setReceiveBufferLimit(int limit);
+    const ReceiveBuffer &getReceiveBuffer() const;
+
+    // Opt-in: payloads of at least threshold bytes go to the sink instead of
+    // the tree. The sink is not owned, pass NULL to disable.
+    void setPayloadSink(PayloadSink *sink, int threshold = PAYLOADSINK_DEFAULT_THRESHOLD);
+    qint64 getBytesStreamed() const;
+    qint64 getBytesBuffered() const;
+
+    // Top level stanzas with this tag (and attribute, or attribute value, if
+    // given) are dropped as soon as their attributes are read, without
+    // decoding the rest of the frame. Arguments are token ids.
+    void addStanzaFilter(int tag, int attribute = -1, int value = -1);
+    void clearStanzaFilters();
+    int getFilteredStanzas() const;
+
 private:
+    enum FrameState {
+        ReadingHeader,
+        ReadingBody
+    };
+
+    struct StanzaFilter {
+        int tag;
+        int attribute;
+        int value;
+    };
+
     WATokenDictionary *dict;
-    QTcpSocket *socket;
+    QIODevice *socket;
     KeyStream *inputKey;
 
-    QByteArray rawBuffer;
-    QByteArray decodedBuffer;
-    QBuffer decodedStream;
+    // Incremental frame state, kept between readyRead() signals
+    FrameState frameState;
+    qint8 frameFlags;
+    qint32 frameSize;
+    qint32 frameConsumed;
+    bool waitingForData;
+
+    // Frames are decrypted in place in the receive buffer and parsed through a cursor
+    ReceiveBuffer receiveBuffer;
+    const char *readBegin;
+    const char *readPos;
+    const char *readEnd;
+
+    ProtocolTreeNodeIndex index;
+
+    PayloadSink *payloadSink;
+    int payloadThreshold;
+    qint64 bytesStreamed;
+    qint64 bytesBuffered;
+
+    QVector<StanzaFilter> stanzaFilters;
+    bool stanzaFiltered;
+    int filteredStanzas;
 
     //everthing goes bad, clean up
     void harakiri();
@@ -72,22 +133,21 @@ private:
     bool decodeRawStream(qint8 flags, qint32 offset, qint32 length);
 
     //Raw stream reads
-    bool fillRawBuffer(quint32 stanzaSize);
-    bool fillArrayFromRawStream(QByteArray& buffer, quint32 len);
-
-    qint32 readRawInt16();
-    qint32 readRawInt24();
+    bool fillRawBuffer();
+    bool readSocket(int needed);
 
-    //Decoded stream reads
-    bool nextTreeInternal(ProtocolTreeNode& node);
+    //Decoded stream reads, strings are returned as ProtocolTreeNodeIndex references
+    bool nextTreeInternal(int& node);
     bool readListSize(qint32 token, int &size);
-    bool readList(qint32 token,ProtocolTreeNode& node);
-
-    bool fillArray(QByteArray& buffer, quint32 len);
-    bool readAttributes(AttributeList& attribs, int attribCount);
-    bool readString(QByteArray& s);
-    bool readString(qint32 token, QByteArray& s);
-    bool getToken(qint32 token, QByteArray &s);
+    bool readList(qint32 token, int node);
+
+    bool skipArray(quint32 len);
+    bool readAttributes(int node, int attribCount);
+    bool readString(int& s);
+    bool readString(qint32 token, int& s);
+    bool getToken(qint32 token, int &s);
+    void streamPayloads();
+    bool isFiltered(int node);
 
     bool readInt8(quint8 &val);
     bool readInt16(qint16 &val);
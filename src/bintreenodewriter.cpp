@@ -26,17 +26,79 @@
  * official policies, either expressed or implied, of the copyright holder.
  */
 
+#include <string.h>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#include <QNetworkProxy>
+
 #include "attributelistiterator.h"
 #include "protocoltreenodelistiterator.h"
 #include "bintreenodewriter.h"
+#include "walog.h"
 
+// Same bytes as QString::toUtf8(), which writes an unpaired surrogate as '?'
+static char *writeUtf8(const QChar *string, int length, char *out)
+{
+    for (int i = 0; i < length; i++) {
+        uint u = string[i].unicode();
+        if (u < 0x80) {
+            *out++ = (char) u;
+            continue;
+        }
+        if (u < 0x800) {
+            *out++ = (char) (0xc0 | (u >> 6));
+            *out++ = (char) (0x80 | (u & 0x3f));
+            continue;
+        }
+        if (string[i].isHighSurrogate() && i + 1 < length && string[i + 1].isLowSurrogate()) {
+            u = QChar::surrogateToUcs4(string[i], string[i + 1]);
+            i++;
+            *out++ = (char) (0xf0 | (u >> 18));
+            *out++ = (char) (0x80 | ((u >> 12) & 0x3f));
+            *out++ = (char) (0x80 | ((u >> 6) & 0x3f));
+            *out++ = (char) (0x80 | (u & 0x3f));
+            continue;
+        }
+        if (string[i].isHighSurrogate() || string[i].isLowSurrogate()) {
+            *out++ = '?';
+            continue;
+        }
+        *out++ = (char) (0xe0 | (u >> 12));
+        *out++ = (char) (0x80 | ((u >> 6) & 0x3f));
+        *out++ = (char) (0x80 | (u & 0x3f));
+    }
+    return out;
+}
 
-BinTreeNodeWriter::BinTreeNodeWriter(QTcpSocket *socket, WATokenDictionary *dict,
+BinTreeNodeWriter::BinTreeNodeWriter(QIODevice *socket, WATokenDictionary *dict,
                                      QObject *parent) : QObject(parent)
 {
     this->socket = socket;
     this->dict = dict;
 
+    // Kept across frames, resize(0) doesn't release it
+    stringClasses.reserve(256);
+
+    coalescing = false;
+    holds = 0;
+    coalesceMaxBytes = WRITER_COALESCE_MAX_BYTES;
+    coalesceMaxDelay = WRITER_COALESCE_MAX_DELAY;
+    framesWritten = 0;
+    flushes = 0;
+    bytesWrittenDirect = 0;
+
+    // Zero interval: fires as soon as the event loop gets control back
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(0);
+    connect(flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
     reset();
 }
 
@@ -44,10 +106,63 @@ void BinTreeNodeWriter::reset()
 {
     crypto = false;
     writeBuffer.clear();
+    writePos = NULL;
+    nextStringClass = 0;
     dataBegin = 0;
+    pendingBytes = 0;
+    pendingFrames = 0;
+    flushTimer->stop();
     this->outputKey = NULL;
 }
 
+void BinTreeNodeWriter::setCoalescing(bool enabled, int maxBytes, int maxDelay)
+{
+    writeMutex.lock();
+    coalescing = enabled;
+    coalesceMaxBytes = maxBytes;
+    coalesceMaxDelay = maxDelay;
+    if (!coalescing)
+        writePending(false);
+    writeMutex.unlock();
+}
+
+bool BinTreeNodeWriter::isCoalescing() const
+{
+    return coalescing;
+}
+
+void BinTreeNodeWriter::hold()
+{
+    writeMutex.lock();
+    holds++;
+    writeMutex.unlock();
+}
+
+void BinTreeNodeWriter::release()
+{
+    writeMutex.lock();
+    if (holds > 0 && --holds == 0 && !coalescing)
+        writePending(false);
+    writeMutex.unlock();
+}
+
+qint64 BinTreeNodeWriter::getFramesWritten() const
+{
+    return framesWritten;
+}
+
+qint64 BinTreeNodeWriter::getFlushes() const
+{
+    return flushes;
+}
+
+void BinTreeNodeWriter::flush()
+{
+    writeMutex.lock();
+    writePending(false);
+    writeMutex.unlock();
+}
+
 /*
  *************************************************************************************
  * WRITER METHODS
@@ -56,64 +171,85 @@ void BinTreeNodeWriter::reset()
 
 int BinTreeNodeWriter::streamStart(const QString& domain, const QString& resource)
 {
-    qDebug() << "sending streamStart to" << domain << resource;
-
-    startBuffer();
-    QDataStream out(&writeBuffer,QIODevice::WriteOnly);
+    WA_LOG(WALogConnection, WALogInfo) << "sending streamStart to" << domain << resource;
 
-    writeInt8(0x57, out);
-    writeInt8(0x41, out);
-    writeInt8(1, out);
-    writeInt8(5, out);
+    static const char header[] = { 0x57, 0x41, 1, 5 };
 
     AttributeList streamOpenAttributes;
     streamOpenAttributes.insert("resource", resource);
     streamOpenAttributes.insert("to", domain);
 
-    writeDummyHeader(out);
-    writeListStart(streamOpenAttributes.size() * 2 + 1, out);
-    writeInt8(1, out);
-    writeAttributes(streamOpenAttributes, out);
+    return writeFrame(ProtocolTreeNode("stream:start", streamOpenAttributes),
+                      header, sizeof(header), false);
+}
 
-    int bytes = writeBuffer.size();
+int BinTreeNodeWriter::streamEnd()
+{
+    return writeFrame(ProtocolTreeNode("stream:close"), NULL, 0, true);
+}
 
-    flushBuffer(false);
+int BinTreeNodeWriter::write(const ProtocolTreeNode &node, bool needsFlush)
+{
+    if (node.getTag() == "")
+    {
+        qDebug() << "<noop>";
+    }
+    else
+    {
+        WA_LOG(WALogProtocol, WALogDebug) << "write" << node.toString(0, WALog::getDumpLimit());
+    }
 
-    return bytes;
+    return writeFrame(node, NULL, 0, needsFlush);
 }
 
-int BinTreeNodeWriter::streamEnd()
+int BinTreeNodeWriter::writeFrame(const ProtocolTreeNode &node, const char *prefix,
+                                  int prefixLength, bool flushNetwork)
 {
     writeMutex.lock();
-    startBuffer();
-    QDataStream out(&writeBuffer,QIODevice::WriteOnly);
 
-    writeDummyHeader(out);
-    writeListStart(1, out);
-    writeInt8(2, out);
+    // The exact size is known before writing, so the frame is built with a
+    // single allocation (none once the buffer has grown) and raw stores
+    stringClasses.resize(0);
+    nextStringClass = 0;
 
-    int bytes = writeBuffer.size();
+    int size = (node.getTag() == "") ? 1 : nodeSize(node);
+    startBuffer(prefixLength, size);
+    if (prefixLength > 0)
+        memcpy(writeBuffer.data() + pendingBytes, prefix, prefixLength);
 
-    flushBuffer(true);
+    if (node.getTag() == "")
+        writeInt8(0);
+    else
+        writeInternal(node);
+
+    Q_ASSERT(writePos == writeBuffer.constData() + dataBegin + 3 + size);
+
+    // Everything but the MAC
+    int bytes = prefixLength + 3 + size;
+
+    flushBuffer(flushNetwork);
     writeMutex.unlock();
 
     return bytes;
 }
 
-void BinTreeNodeWriter::writeDummyHeader(QDataStream& out)
-{
-    dataBegin = writeBuffer.size();
-    writeInt24(0, out);
-}
-
 /*
  * Buffer management methods
  */
 
-void BinTreeNodeWriter::startBuffer()
+void BinTreeNodeWriter::startBuffer(int prefixLength, int payloadSize)
 {
-    writeBuffer.clear();
-    dataBegin = 0;
+    // The new frame goes after the queued ones, if any
+    dataBegin = pendingBytes + prefixLength;
+
+    // resize() alone gives the memory back when a frame is much smaller
+    // than the previous one. Once reserve() was called it only ever grows
+    // the allocation, so the buffer stays at the largest frame so far.
+    int size = dataBegin + 3 + payloadSize + (crypto ? 4 : 0);
+    if (size > writeBuffer.capacity())
+        writeBuffer.reserve(size);
+    writeBuffer.resize(size);
+    writePos = writeBuffer.data() + dataBegin + 3;
 }
 
 void BinTreeNodeWriter::processBuffer()
@@ -121,23 +257,23 @@ void BinTreeNodeWriter::processBuffer()
     int num = 0;
     //qDebug() << ">> " + QString(writeBuffer.toHex());
 
+    // The MAC space was already reserved by startBuffer()
     if (crypto)
     {
-        qint64 num2 = writeBuffer.size() + 4;
-        writeBuffer.resize(num2);
         num |= 8;
     }
 
     qint64 num3 = writeBuffer.size() - 3 - dataBegin;
     if (num3 > 0x1000000) {
-        qDebug() << "Buffer too large:" << QString::number(num3);
+        WA_LOG(WALogNetwork, WALogError) << "Buffer too large:" << QString::number(num3);
         harakiri();
     }
 
     if (crypto)
     {
         int length = ((int) num3) - 4;
-        outputKey->encodeMessage(writeBuffer,(dataBegin + 3) + length, dataBegin + 3, length);
+        char *payload = writeBuffer.data() + dataBegin + 3;
+        outputKey->encodeMessage(payload, length, payload + length);
     }
 
     char *buffer = writeBuffer.data();
@@ -150,18 +286,116 @@ void BinTreeNodeWriter::processBuffer()
 void BinTreeNodeWriter::flushBuffer(bool flushNetwork)
 {
     processBuffer();
+    if (writeBuffer.isEmpty())  // harakiri()
+        return;
+
+    pendingBytes = writeBuffer.size();
+    pendingFrames++;
+
+    if ((coalescing || holds > 0) && !flushNetwork) {
+        if (pendingFrames == 1) {
+            pendingAge.start();
+            flushTimer->start();
+        }
+        // Only the size limit applies while held
+        if (pendingBytes < coalesceMaxBytes
+                && (holds > 0 || pendingAge.elapsed() < coalesceMaxDelay))
+            return;
+    }
+
+    writePending(flushNetwork);
+}
+
+void BinTreeNodeWriter::writePending(bool flushNetwork)
+{
+    flushTimer->stop();
+    if (pendingFrames == 0)
+        return;
 
     // Write buffer
     //qDebug() << ">> " + QString(writeBuffer.toHex());
-    if ((socket->write(writeBuffer)) == -1) {
-        qDebug() << "error writing buffer";
+    int written = writeDirect(writeBuffer.constData(), pendingBytes);
+    if (written < pendingBytes &&
+            (socket->write(writeBuffer.constData() + written, pendingBytes - written)) == -1) {
+        WA_LOG(WALogNetwork, WALogError) << "error writing buffer";
         harakiri();
+        return;
     }
 
-    if (flushNetwork)
-        socket->flush();
+    framesWritten += pendingFrames;
+    flushes++;
+    pendingFrames = 0;
+    pendingBytes = 0;
 
-    writeBuffer.clear();
+    if (flushNetwork) {
+        QAbstractSocket *tcpSocket = qobject_cast<QAbstractSocket*>(socket);
+        if (tcpSocket)
+            tcpSocket->flush();
+    }
+}
+
+/*
+ * Hands the data straight to the kernel when Qt has nothing buffered for
+ * the socket, saving the copy into QTcpSocket's write buffer. Returns the
+ * number of bytes sent, the caller writes the rest through the socket.
+ */
+int BinTreeNodeWriter::writeDirect(const char *data, int length)
+{
+#ifdef Q_OS_LINUX
+    int fd = directDescriptor();
+    if (fd < 0)
+        return 0;
+
+    struct iovec iov;
+    iov.iov_base = (void *) data;
+    iov.iov_len = length;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    // Errors are left for QTcpSocket to find and report
+    if (sent <= 0)
+        return 0;
+
+    bytesWrittenDirect += sent;
+    return (int) sent;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(length);
+    return 0;
+#endif
+}
+
+// Descriptor usable for direct writes, -1 if the data must go through Qt
+int BinTreeNodeWriter::directDescriptor()
+{
+    // Not for QSslSocket (or anything else built on QTcpSocket that
+    // transforms the data) nor through a proxy
+    QTcpSocket *tcpSocket = qobject_cast<QTcpSocket*>(socket);
+    if (!tcpSocket || tcpSocket->metaObject() != &QTcpSocket::staticMetaObject)
+        return -1;
+    if (tcpSocket->state() != QAbstractSocket::ConnectedState || tcpSocket->bytesToWrite() > 0)
+        return -1;
+
+    QNetworkProxy::ProxyType proxy = tcpSocket->proxy().type();
+    if (proxy == QNetworkProxy::DefaultProxy)
+        proxy = QNetworkProxy::applicationProxy().type();
+    if (proxy != QNetworkProxy::NoProxy)
+        return -1;
+
+    return (int) tcpSocket->socketDescriptor();
+}
+
+qint64 BinTreeNodeWriter::getBytesWrittenDirect() const
+{
+    return bytesWrittenDirect;
 }
 
 /*
@@ -172,7 +406,7 @@ void BinTreeNodeWriter::realWrite8(quint8 c)
 {
     //qDebug() << ">> " + QString::number(c,16);
     if ((socket->write((char *)&c, 1)) == -1) {
-        qDebug() << "error writing buffer";
+        WA_LOG(WALogNetwork, WALogError) << "error writing buffer";
         harakiri();
     }
 }
@@ -183,191 +417,306 @@ void BinTreeNodeWriter::realWrite16(quint16 data)
     realWrite8((quint8)(data & 0xFF));
 }
 
-
 /*
- * High level write methods
+ * Size computation, must match the write methods below byte for byte
  */
 
-int BinTreeNodeWriter::write(const ProtocolTreeNode &node, bool needsFlush)
+int BinTreeNodeWriter::nodeSize(const ProtocolTreeNode &node)
 {
-    writeMutex.lock();
-    startBuffer();
-    QDataStream out(&writeBuffer,QIODevice::WriteOnly);
+    int size = listStartSize(1 + (node.getAttributesCount() * 2)
+                             + (node.getChildrenCount() == 0 ? 0 : 1)
+                             + (node.getData().length() == 0 ? 0 : 1));
 
-    writeDummyHeader(out);
+    size += stringSize(node.getTag());
 
-    if (node.getTag() == "")
+    AttributeListIterator i(node.getAttributes());
+    while (i.hasNext())
     {
-        qDebug() << "<noop>";
-        writeInt8(0, out);
+        i.next();
+        size += stringSize(i.key());
+        size += stringSize(i.value().toString());
     }
-    else
+
+    if (node.getData().length() > 0)
+        size += arraySize(node.getData().length());
+
+    if (node.getChildrenCount() > 0)
     {
-        qDebug() << "write" << node.toString();
-        writeInternal(node, out);
+        size += listStartSize(node.getChildrenCount());
+        ProtocolTreeNodeListIterator children(node.getChildren());
+        while (children.hasNext())
+            size += nodeSize(children.next().value());
     }
+    return size;
+}
 
-    int bytes = writeBuffer.size();
+int BinTreeNodeWriter::listStartSize(qint32 i)
+{
+    if (i == 0)
+        return 1;
+    return (i < 0x100) ? 2 : 3;
+}
 
-    flushBuffer(needsFlush);
-    writeMutex.unlock();
+int BinTreeNodeWriter::stringSize(const QString &string)
+{
+    return stringSize(string.constData(), string.size());
+}
 
-    return bytes;
+int BinTreeNodeWriter::stringSize(const QChar *string, int length)
+{
+    // The write pass visits the strings in the same order and reuses this
+    StringClass stringClass = classifyString(string, length);
+    stringClasses.append(stringClass);
+
+    switch (stringClass.type) {
+    case EmptyString:
+        return 2;
+    case TokenString:
+        return (stringClass.value >= WATOKEN_PRIMARY_COUNT) ? 2 : 1;
+    case JidString: {
+        int at = stringClass.value;
+        return 1 + (at > 0 ? stringSize(string, at) : 1)
+                + stringSize(string + at + 1, length - at - 1);
+    }
+    case NibbleString:
+        return 2 + (length + 1) / 2;
+    default:
+        return arraySize(stringClass.value);
+    }
 }
 
-void BinTreeNodeWriter::writeInternal(const ProtocolTreeNode &node, QDataStream& out)
+BinTreeNodeWriter::StringClass BinTreeNodeWriter::classifyString(const QChar *string, int length)
+{
+    StringClass result;
+
+    if (length == 0) {
+        result.type = EmptyString;
+        result.value = 0;
+        return result;
+    }
+
+    // Bails out on the length alone for anything longer than a token
+    int token = WATokenDictionary::tokenId(string, length);
+    if (token >= 0) {
+        result.type = TokenString;
+        result.value = token;
+        return result;
+    }
+
+    // Single forward scan: jid separator, nibble alphabet and UTF-8 length
+    int at = -1;
+    int separators = 0;
+    bool packable = length <= NIBBLE_MAX_LENGTH;
+    int utf8Length = 0;
+    for (int i = 0; i < length; i++) {
+        ushort u = string[i].unicode();
+        if (u < 0x80) {
+            utf8Length++;
+            if (u == '@') {
+                separators++;
+                at = i;
+            }
+            packable = packable && NibbleCodec::isPackable(u);
+        }
+        else {
+            packable = false;
+            if (u < 0x800)
+                utf8Length += 2;
+            else if (string[i].isHighSurrogate() && i + 1 < length && string[i + 1].isLowSurrogate()) {
+                utf8Length += 4;
+                i++;
+            }
+            else if (string[i].isHighSurrogate() || string[i].isLowSurrogate())
+                utf8Length++;
+            else
+                utf8Length += 3;
+        }
+    }
+
+    if (separators == 1) {
+        result.type = JidString;
+        result.value = at;
+    }
+    else if (packable) {
+        result.type = NibbleString;
+        result.value = 0;
+    }
+    else {
+        result.type = RawString;
+        result.value = utf8Length;
+    }
+    return result;
+}
+
+int BinTreeNodeWriter::arraySize(int length)
+{
+    return ((length >= 256) ? 4 : 2) + length;
+}
+
+/*
+ * High level write methods
+ */
+
+void BinTreeNodeWriter::writeInternal(const ProtocolTreeNode &node)
 {
     writeListStart(1 + (node.getAttributesCount() * 2)
                    + (node.getChildrenCount() == 0 ? 0 : 1)
-                   + (node.getData().length() == 0 ? 0 : 1), out);
+                   + (node.getData().length() == 0 ? 0 : 1));
 
-    writeString(node.getTag(), out);
-    writeAttributes(node.getAttributes(), out);
+    writeString(node.getTag());
+    writeAttributes(node.getAttributes());
     if (node.getData().length() > 0)
-        writeArray(node.getData(), out);
+        writeArray(node.getData());
     if (node.getChildrenCount() > 0)
     {
-        writeListStart(node.getChildrenCount(), out);
+        writeListStart(node.getChildrenCount());
         ProtocolTreeNodeListIterator i(node.getChildren());
         while (i.hasNext())
-        {
-            ProtocolTreeNode child = i.next().value();
-            writeInternal(child, out);
-        }
+            writeInternal(i.next().value());
     }
 }
 
-void BinTreeNodeWriter::writeListStart(qint32 i, QDataStream& out)
+void BinTreeNodeWriter::writeListStart(qint32 i)
 {
     if (i == 0)
     {
-        writeInt8(0, out);
+        writeInt8(0);
     }
     else if (i < 0x100)
     {
-        writeInt8(0xf8, out);
-        writeInt8(i, out);
+        writeInt8(0xf8);
+        writeInt8(i);
     }
     else
     {
-        writeInt8(0xf9, out);
-        writeInt16(i, out);
+        writeInt8(0xf9);
+        writeInt16(i);
     }
 }
 
-void BinTreeNodeWriter::writeAttributes(const AttributeList& attributes, QDataStream &out)
+void BinTreeNodeWriter::writeAttributes(const AttributeList& attributes)
 {
     AttributeListIterator i(attributes);
     while (i.hasNext())
     {
         i.next();
-        writeString(i.key(), out);
-        writeString(i.value().toString(), out);
+        writeString(i.key());
+        writeString(i.value().toString());
     }
 }
 
-void BinTreeNodeWriter::writeString(const QString &tag, QDataStream& out)
+void BinTreeNodeWriter::writeString(const QString &string)
 {
-    if (tag.size() == 0)
-    {
-        writeInt8(0xfc, out);
-        writeInt8(0, out);
-    }
-    else {
-        int token;
-        bool subdict;
-        if (dict->tryGetToken(tag, subdict, token)) {
-            if (subdict)
-                writeToken(dict->primarySize(), out);
-            writeToken(token, out);
-        }
-        else if (tag.split("@").count() == 2) {
-            writeJid(tag, out);
-        }
-        else if (QRegExp("[0-9.-]*").exactMatch(tag)) {
-            writeNibbles(tag.toUtf8(), out);
-        }
-        else {
-            writeArray(tag.toUtf8(), out);
+    writeString(string.constData(), string.size());
+}
+
+void BinTreeNodeWriter::writeString(const QChar *string, int length)
+{
+    StringClass stringClass = stringClasses.at(nextStringClass++);
+
+    switch (stringClass.type) {
+    case EmptyString:
+        writeInt8(0xfc);
+        writeInt8(0);
+        break;
+    case TokenString: {
+        int token = stringClass.value;
+        if (token >= WATOKEN_PRIMARY_COUNT) {
+            writeToken(WATOKEN_PRIMARY_COUNT);
+            token -= WATOKEN_PRIMARY_COUNT;
         }
+        writeToken(token);
+        break;
+    }
+    case JidString: {
+        int at = stringClass.value;
+        writeJid(string, at, string + at + 1, length - at - 1);
+        break;
+    }
+    case NibbleString:
+        writeNibbles(string, length);
+        break;
+    default:
+        writeArrayHeader(stringClass.value);
+        writePos = writeUtf8(string, length, writePos);
+        break;
     }
 }
 
-void BinTreeNodeWriter::writeJid(const QString &tag, QDataStream& out)
+void BinTreeNodeWriter::writeJid(const QChar *user, int userLength,
+                                 const QChar *server, int serverLength)
 {
-    QStringList jid = tag.split("@");
-
-    writeInt8(0xfa, out);
-    if (jid[0].length() > 0)
-        writeString(jid[0], out);
+    writeInt8(0xfa);
+    if (userLength > 0)
+        writeString(user, userLength);
     else
-        writeToken(0, out);
-    writeString(jid[1], out);
+        writeToken(0);
+    writeString(server, serverLength);
 }
 
-void BinTreeNodeWriter::writeToken(qint32 intValue, QDataStream& out)
+void BinTreeNodeWriter::writeToken(qint32 intValue)
 {
     //qDebug() << "writeToken:" << QString::number(intValue, 16);
     if (intValue < 0xf5)
-        writeInt8(intValue, out);
+        writeInt8(intValue);
     else if (intValue <= 500)
     {
-        writeInt8(0xfe, out);
-        writeInt8(intValue - 245, out);
+        writeInt8(0xfe);
+        writeInt8(intValue - 245);
     }
 }
 
-void BinTreeNodeWriter::writeArray(const QByteArray &bytes, QDataStream& out)
+void BinTreeNodeWriter::writeArray(const QByteArray &bytes)
+{
+    writeArrayHeader(bytes.length());
+    writeInt8Array(bytes.constData(), bytes.length());
+}
+
+void BinTreeNodeWriter::writeArrayHeader(int length)
 {
-    if (bytes.length() >= 256)
+    if (length >= 256)
     {
-        writeInt8(0xfd, out);
-        writeInt24(bytes.length(), out);
+        writeInt8(0xfd);
+        writeInt24(length);
     }
     else
     {
-        writeInt8(0xfc, out);
-        writeInt8(bytes.length(), out);
+        writeInt8(0xfc);
+        writeInt8(length);
     }
-
-    writeInt8Array(bytes, out);
 }
 
-void BinTreeNodeWriter::writeInt8Array(const QByteArray &bytes, QDataStream &out)
+void BinTreeNodeWriter::writeInt8Array(const char *data, int length)
 {
-    out.writeRawData(bytes.constData(), bytes.size());
+    memcpy(writePos, data, length);
+    writePos += length;
 }
 
-void BinTreeNodeWriter::writeNibbles(const QByteArray &bytes, QDataStream &out)
+void BinTreeNodeWriter::writeNibbles(const QChar *string, int length)
 {
-    QByteArray result(bytes);
-    if (result.size() % 2 == 1) {
-        result.append('0');
-    }
-    result.replace('-', 'a').replace('.', 'b');
-    result = QByteArray::fromHex(result);
-    int numn = (bytes.size() + 1) / 2;
-    if (bytes.size() % 2 != 0) numn |= 0x80;
-
-    writeInt8(0xff, out);
-    writeInt8(numn, out);
-    writeInt8Array(result, out);
+    writeInt8(0xff);
+    writeInt8(((length + 1) / 2) | ((length % 2) ? 0x80 : 0));
+    writePos += NibbleCodec::encode(string, length, writePos);
 }
 
-void BinTreeNodeWriter::writeInt8(quint8 v, QDataStream& out)
+void BinTreeNodeWriter::writeInt8(quint8 v)
 {
-    out << v;
+    *writePos++ = (char) v;
 }
 
-void BinTreeNodeWriter::writeInt16(quint16 v, QDataStream& out)
+void BinTreeNodeWriter::writeInt16(quint16 v)
 {
-    out << v;
+    writePos[0] = (char) (v >> 8);
+    writePos[1] = (char) v;
+    writePos += 2;
 }
 
-void BinTreeNodeWriter::writeInt24(quint32 v, QDataStream& out)
+void BinTreeNodeWriter::writeInt24(quint32 v)
 {
-    out << ((quint8)((v & 0xFF0000) >> 16));
-    out << ((quint16)((v & 0xFFFF)));
+    writePos[0] = (char) ((v & 0xFF0000) >> 16);
+    writePos[1] = (char) ((v & 0xFF00) >> 8);
+    writePos[2] = (char) (v & 0xFF);
+    writePos += 3;
 }
 
 void BinTreeNodeWriter::setOutputKey(KeyStream *outputKey)
@@ -383,7 +732,14 @@ void BinTreeNodeWriter::setCrypto(bool crypto)
 void BinTreeNodeWriter::harakiri()
 {
     QObject::disconnect(socket, 0, 0, 0);
-    socket->disconnectFromHost();
+    QAbstractSocket *tcpSocket = qobject_cast<QAbstractSocket*>(socket);
+    if (tcpSocket)
+        tcpSocket->disconnectFromHost();
+    else
+        socket->close();
     writeBuffer.clear();
+    pendingBytes = 0;
+    pendingFrames = 0;
+    flushTimer->stop();
     Q_EMIT socketBroken();
 }
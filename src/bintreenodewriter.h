@@ -29,22 +29,32 @@
 #ifndef BINTREENODEWRITER_H
 #define BINTREENODEWRITER_H
 
-#include <QDataStream>
 #include <QStringList>
 #include <QTcpSocket>
 #include <QMutex>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
 
 #include "keystream.h"
+#include "nibblecodec.h"
 #include "attributelist.h"
 #include "protocoltreenodelist.h"
 #include "watokendictionary.h"
 
+// Coalescing limits: queued frames are written once this many bytes are
+// pending or the oldest one has waited this many milliseconds, even if the
+// event loop didn't get control back yet
+#define WRITER_COALESCE_MAX_BYTES   0x4000
+#define WRITER_COALESCE_MAX_DELAY   20
+
 class BinTreeNodeWriter : public QObject
 {
     Q_OBJECT
 
 public:
-    BinTreeNodeWriter(QTcpSocket *socket, WATokenDictionary *dict,
+    // socket is usually a QTcpSocket, any sequential device works
+    BinTreeNodeWriter(QIODevice *socket, WATokenDictionary *dict,
                       QObject *parent = 0);
 
     void reset();
@@ -57,37 +67,112 @@ public:
     void setOutputKey(KeyStream *outputKey);
     void setCrypto(bool crypto);
 
+    // When enabled, frames not written with needsFlush are queued and
+    // handed to the socket as one buffer when control returns to the
+    // event loop, or earlier if one of the limits is reached
+    void setCoalescing(bool enabled, int maxBytes = WRITER_COALESCE_MAX_BYTES,
+                       int maxDelay = WRITER_COALESCE_MAX_DELAY);
+    bool isCoalescing() const;
+
+    // Queues frames like coalescing does until the matching release(),
+    // which writes them unless coalescing is on anyway. Calls nest and
+    // leave the coalescing settings alone.
+    void hold();
+    void release();
+
+    // Frames handed to the socket and the number of socket writes used
+    qint64 getFramesWritten() const;
+    qint64 getFlushes() const;
+
+    // Bytes sent on the socket descriptor without going through Qt's
+    // write buffer (Linux only)
+    qint64 getBytesWrittenDirect() const;
+
+public slots:
+    // Writes the queued frames now
+    void flush();
+
 private:
     QHash<QString, int> tokenMap;
-    QTcpSocket *socket;
+    QIODevice *socket;
     WATokenDictionary *dict;
     QByteArray writeBuffer;
+    char *writePos;
+
+    // How each string is encoded, filled by the size pass and consumed in
+    // the same order by the write pass
+    enum StringType {
+        EmptyString,
+        TokenString,
+        JidString,
+        NibbleString,
+        RawString
+    };
+
+    // value: token id, '@' position or UTF-8 length
+    struct StringClass {
+        int type;
+        int value;
+    };
+
+    QVector<StringClass> stringClasses;
+    int nextStringClass;
     QMutex writeMutex;
     qint32 dataBegin;
+
+    // Queued frames are kept at the start of writeBuffer
+    bool coalescing;
+    int holds;
+    int coalesceMaxBytes;
+    int coalesceMaxDelay;
+    int pendingBytes;
+    int pendingFrames;
+    QElapsedTimer pendingAge;
+    QTimer *flushTimer;
+    qint64 framesWritten;
+    qint64 flushes;
+    qint64 bytesWrittenDirect;
+
     KeyStream *outputKey;
     bool crypto;
 
     void harakiri();
 
     // Writer methods
-    void startBuffer();
+    int writeFrame(const ProtocolTreeNode &node, const char *prefix, int prefixLength,
+                   bool flushNetwork);
+    void startBuffer(int prefixLength, int payloadSize);
     void processBuffer();
     void flushBuffer(bool flushNetwork);
+    void writePending(bool flushNetwork);
+    int writeDirect(const char *data, int length);
+    int directDescriptor();
     void realWrite8(quint8 c);
     void realWrite16(quint16 data);
-    void writeDummyHeader(QDataStream& out);
-    void writeInternal(const ProtocolTreeNode& node, QDataStream& out);
-    void writeListStart(qint32 i, QDataStream& out);
-    void writeAttributes(const AttributeList& attributes, QDataStream& out);
-    void writeString(const QString &tag, QDataStream& out);
-    void writeJid(const QString &tag, QDataStream& out);
-    void writeToken(qint32 intValue, QDataStream& out);
-    void writeArray(const QByteArray &bytes, QDataStream& out);
-    void writeInt8Array(const QByteArray &bytes, QDataStream& out);
-    void writeNibbles(const QByteArray &bytes, QDataStream& out);
-    void writeInt8(quint8 v, QDataStream& out);
-    void writeInt16(quint16 v, QDataStream& out);
-    void writeInt24(quint32 v, QDataStream& out);
+
+    // Encoded sizes, computed before writing so the buffer is sized once
+    int nodeSize(const ProtocolTreeNode& node);
+    int listStartSize(qint32 i);
+    int stringSize(const QString &string);
+    int stringSize(const QChar *string, int length);
+    StringClass classifyString(const QChar *string, int length);
+    int arraySize(int length);
+
+    // Encoding, straight into writeBuffer through writePos
+    void writeInternal(const ProtocolTreeNode& node);
+    void writeListStart(qint32 i);
+    void writeAttributes(const AttributeList& attributes);
+    void writeString(const QString &string);
+    void writeString(const QChar *string, int length);
+    void writeJid(const QChar *user, int userLength, const QChar *server, int serverLength);
+    void writeToken(qint32 intValue);
+    void writeArray(const QByteArray &bytes);
+    void writeArrayHeader(int length);
+    void writeInt8Array(const char *data, int length);
+    void writeNibbles(const QChar *string, int length);
+    void writeInt8(quint8 v);
+    void writeInt16(quint16 v);
+    void writeInt24(quint32 v);
 
 signals:
     void socketBroken();
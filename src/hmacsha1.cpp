@@ -2,41 +2,54 @@
 
 HmacSha1::HmacSha1(const QByteArray &key)
 {
-#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
-    m_mac = new QMessageAuthenticationCode(QCryptographicHash::Sha1, key);
-#else
-    m_key = key;
-#endif
+    // Keys longer than the block size are hashed first (RFC 2104)
+    char keyHash[SHA1_DIGEST_SIZE];
+    const char *keyData = key.constData();
+    int keyLength = key.length();
+    if (keyLength > SHA1_BLOCK_SIZE) {
+        Sha1::hash(keyData, keyLength, keyHash);
+        keyData = keyHash;
+        keyLength = SHA1_DIGEST_SIZE;
+    }
+
+    char innerPadding[SHA1_BLOCK_SIZE];
+    char outerPadding[SHA1_BLOCK_SIZE];
+    for (int i = 0; i < SHA1_BLOCK_SIZE; i++) {
+        char k = (i < keyLength) ? keyData[i] : 0;
+        innerPadding[i] = k ^ 0x36;
+        outerPadding[i] = k ^ 0x5c;
+    }
+
+    m_innerStart.update(innerPadding, SHA1_BLOCK_SIZE);
+    m_outerStart.update(outerPadding, SHA1_BLOCK_SIZE);
+    m_inner = m_innerStart;
 }
 
 QByteArray HmacSha1::hmacSha1(const QByteArray &buffer)
 {
-#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
-    m_mac->reset();
-    m_mac->addData(buffer);
-    return m_mac->result();
-#else
-    int blockSize = 64; // HMAC-SHA-1 block size, defined in SHA-1 standard
-    if (m_key.length() > blockSize) { // if key is longer than block size (64), reduce key length with SHA-1 compression
-        m_key = QCryptographicHash::hash(m_key, QCryptographicHash::Sha1);
-    }
+    QByteArray mac(SHA1_DIGEST_SIZE, 0);
+    reset();
+    update(buffer.constData(), buffer.length());
+    final(mac.data());
+    return mac;
+}
 
-    QByteArray innerPadding(blockSize, char(0x36)); // initialize inner padding with char "6"
-    QByteArray outerPadding(blockSize, char(0x5c)); // initialize outer padding with char "\"
-    // ascii characters 0x36 ("6") and 0x5c ("\") are selected because they have large
-    // Hamming distance (http://en.wikipedia.org/wiki/Hamming_distance)
+void HmacSha1::reset()
+{
+    m_inner = m_innerStart;
+}
 
-    for (int i = 0; i < m_key.length(); i++) {
-        innerPadding[i] = innerPadding[i] ^ m_key.at(i); // XOR operation between every byte in key and innerpadding, of key length
-        outerPadding[i] = outerPadding[i] ^ m_key.at(i); // XOR operation between every byte in key and outerpadding, of key length
-    }
+void HmacSha1::update(const char *data, int length)
+{
+    m_inner.update(data, length);
+}
+
+void HmacSha1::final(char *mac)
+{
+    char innerHash[SHA1_DIGEST_SIZE];
+    m_inner.final(innerHash);
 
-    // result = hash ( outerPadding CONCAT hash ( innerPadding CONCAT baseString ) ).toBase64
-    QByteArray total = outerPadding;
-    QByteArray part = innerPadding;
-    part.append(buffer);
-    total.append(QCryptographicHash::hash(part, QCryptographicHash::Sha1));
-    QByteArray hashed = QCryptographicHash::hash(total, QCryptographicHash::Sha1);
-    return hashed;
-#endif
+    Sha1 outer = m_outerStart;
+    outer.update(innerHash, SHA1_DIGEST_SIZE);
+    outer.final(mac);
 }
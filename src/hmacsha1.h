@@ -1,11 +1,9 @@
 #ifndef HMACSHA1_H
 #define HMACSHA1_H
 
-#include <QObject>
-#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
-#include <QMessageAuthenticationCode>
-#endif
-#include <QCryptographicHash>
+#include <QByteArray>
+
+#include "sha1.h"
 
 class HmacSha1
 {
@@ -14,13 +12,18 @@ public:
 
     QByteArray hmacSha1(const QByteArray &buffer);
 
-private:
-#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
-    QMessageAuthenticationCode *m_mac;
-#else
-    QByteArray m_key;
-#endif
+    // Incremental MAC: reset(), update() as many times as needed, then
+    // final() writes the 20 byte result
+    void reset();
+    void update(const char *data, int length);
+    void final(char *mac);
 
+private:
+    // Hash states right after the inner and outer key pads. They are
+    // computed once per key; every message starts from a copy.
+    Sha1 m_innerStart;
+    Sha1 m_outerStart;
+    Sha1 m_inner;
 };
 
 #endif // HMACSHA1_H
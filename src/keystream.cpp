@@ -28,9 +28,12 @@
 
 #include "keystream.h"
 #include "qtrfc2898.h"
+#include "walog.h"
 
 #include <QDebug>
 
+#include <string.h>
+
 KeyStream::KeyStream(QByteArray rc4key, QByteArray mackey, QObject *parent) : QObject(parent)
 {
     rc4 = new RC4(rc4key, 0x300);
@@ -38,44 +41,43 @@ KeyStream::KeyStream(QByteArray rc4key, QByteArray mackey, QObject *parent) : QO
     seq = 0;
 }
 
-bool KeyStream::decodeMessage(QByteArray& buffer, int macOffset, int offset, int length)
+bool KeyStream::decodeMessage(char *data, int length)
 {
     //qDebug() << "decodeMessage seq:" << seq;
-    QByteArray base = buffer.left(buffer.size() - 4);
-    QByteArray hmac = buffer.right(4);
-    QByteArray buffer2 = processBuffer(base, seq++);
-
-    buffer2 = hmacSha1(buffer2);
+    hmac->reset();
+    for (int offset = 0; offset < length; offset += KEYSTREAM_BLOCK_SIZE) {
+        int n = qMin(length - offset, KEYSTREAM_BLOCK_SIZE);
+        hmac->update(data + offset, n);
+        rc4->Cipher(data, offset, n);
+    }
 
-    QByteArray origBuffer = buffer;
-    buffer = base;
-    rc4->Cipher(buffer.data(), 0, buffer.size());
+    char mac[20];
+    finishMac(seq++, mac);
 
-    for (int i = 0; i < 4; i++)
+    if (memcmp(mac, data + length, 4) != 0)
     {
-        if (buffer2[macOffset + i] != hmac[i])
-        {
-            qDebug() << "error decoding message. macOffset:" << macOffset << "offset:" << offset << "length:" << length << "bufferSize:" << buffer.size();
-            qDebug() << "buffer mac:" << buffer2.toHex() << "hmac:" << hmac.toHex();
-            qDebug() << "buffer:" << buffer.toHex();
-            qDebug() << "origBuffer:" << origBuffer.toHex();
-            return false;
-        }
+        WA_LOG(WALogNetwork, WALogError) << "error decoding message. length:" << length;
+        WA_LOG(WALogNetwork, WALogError) << "buffer mac:" << QByteArray(mac, 4).toHex() << "hmac:" << QByteArray(data + length, 4).toHex();
+        WA_LOG(WALogNetwork, WALogDebug) << "buffer:" << QByteArray(data, length).toHex();
+        return false;
     }
     return true;
 }
 
 
-void KeyStream::encodeMessage(QByteArray &buffer, int macOffset, int offset, int length)
+void KeyStream::encodeMessage(char *data, int length, char *mac)
 {
     //qDebug() << "encodeMessage seq:" << seq;
-    rc4->Cipher(buffer.data(), offset, length);
-    QByteArray base = buffer.mid(offset, length);
-    base = processBuffer(base, seq++);
-
-    QByteArray hmac = hmacSha1(base).left(4);
+    hmac->reset();
+    for (int offset = 0; offset < length; offset += KEYSTREAM_BLOCK_SIZE) {
+        int n = qMin(length - offset, KEYSTREAM_BLOCK_SIZE);
+        rc4->Cipher(data, offset, n);
+        hmac->update(data + offset, n);
+    }
 
-    buffer.replace(macOffset, 4, hmac.constData(), 4);
+    char fullMac[20];
+    finishMac(seq++, fullMac);
+    memcpy(mac, fullMac, 4);
 }
 
 QList<QByteArray> KeyStream::keyFromPasswordAndNonce(const QByteArray& pass, const QByteArray& nonce)
@@ -93,16 +95,14 @@ QList<QByteArray> KeyStream::keyFromPasswordAndNonce(const QByteArray& pass, con
     return keys;
 }
 
-QByteArray KeyStream::processBuffer(QByteArray buffer, int seq)
-{
-    buffer.append(seq >> 0x18);
-    buffer.append(seq >> 0x10);
-    buffer.append(seq >> 0x8);
-    buffer.append(seq);
-    return buffer;
-}
-
-QByteArray KeyStream::hmacSha1(const QByteArray &data)
+void KeyStream::finishMac(int seq, char *mac)
 {
-    return hmac->hmacSha1(data);
+    char seqBytes[4];
+    seqBytes[0] = (char) (seq >> 0x18);
+    seqBytes[1] = (char) (seq >> 0x10);
+    seqBytes[2] = (char) (seq >> 0x8);
+    seqBytes[3] = (char) seq;
+
+    hmac->update(seqBytes, 4);
+    hmac->final(mac);
 }
@@ -35,6 +35,10 @@
 #include "hmacsha1.h"
 #include "rc4.h"
 
+// Frames are ciphered and MACed in blocks of this size, so each block is
+// still in L1 when the second pass reads it
+#define KEYSTREAM_BLOCK_SIZE    0x1000
+
 class KeyStream : public QObject
 {
     Q_OBJECT
@@ -42,16 +46,22 @@ class KeyStream : public QObject
 public:
     explicit KeyStream(QByteArray rc4key, QByteArray mackey, QObject *parent = 0);
 
-    bool decodeMessage(QByteArray& buffer, int macOffset, int offset, int length);
-    void encodeMessage(QByteArray& buffer, int macOffset, int offset, int length);
+    // data holds length bytes of payload followed by the 4 byte MAC,
+    // the payload is decrypted in place
+    bool decodeMessage(char *data, int length);
+
+    // Encrypts length bytes of data in place and writes the 4 byte MAC to
+    // mac, which may be right after the data or anywhere else
+    void encodeMessage(char *data, int length, char *mac);
 
     static QList<QByteArray> keyFromPasswordAndNonce(const QByteArray& pass, const QByteArray& nonce);
     static QByteArray deriveBytes(const QByteArray& password, const QByteArray& salt, int iterations);
 
 private:
-    QByteArray processBuffer(QByteArray buffer, int seq = 0);
+    // Completes the MAC of the ciphertext fed to hmac with the big endian
+    // sequence number
+    void finishMac(int seq, char *mac);
 
-    QByteArray hmacSha1(const QByteArray &data);
     HmacSha1 *hmac;
 
     RC4 *rc4;
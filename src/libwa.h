@@ -5,6 +5,7 @@
 
 #include "waregistration.h"
 #include "waconnection.h"
+#include "waconnectionmanager.h"
 #include "protocoltreenode.h"
 #include "attributelist.h"
 #include "mediadownloader.h"
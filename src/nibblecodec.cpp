@@ -0,0 +1,74 @@
+#include "nibblecodec.h"
+
+static const char nibbleChars[] = "0123456789-.cdef";
+
+// Nibble of every ASCII character the writer packs, -1 for the rest
+static const signed char nibbleValues[0x80] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 11, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static inline int nibbleValue(QChar c)
+{
+    ushort u = c.unicode();
+    return (u < 0x80) ? nibbleValues[u] : -1;
+}
+
+int NibbleCodec::encode(const QChar *string, int length, char *packed)
+{
+    int bytes = length / 2;
+    for (int i = 0; i < bytes; i++) {
+        packed[i] = (char) ((nibbleValue(string[2 * i]) << 4) | nibbleValue(string[2 * i + 1]));
+    }
+
+    // An odd string is padded with a zero nibble
+    if (length % 2) {
+        packed[bytes] = (char) (nibbleValue(string[length - 1]) << 4);
+        bytes++;
+    }
+    return bytes;
+}
+
+void NibbleCodec::decode(const char *packed, int nibbles, char *out)
+{
+    if (nibbles <= 0)
+        return;
+
+    int bytes = nibbles / 2;
+    for (int i = 0; i < bytes; i++) {
+        uchar byte = (uchar) packed[i];
+        out[2 * i] = nibbleChars[byte >> 4];
+        out[2 * i + 1] = nibbleChars[byte & 0x0f];
+    }
+
+    if (nibbles % 2)
+        out[nibbles - 1] = nibbleChars[(uchar) packed[bytes] >> 4];
+}
+
+void NibbleCodec::decode(const char *packed, int nibbles, QChar *out)
+{
+    if (nibbles <= 0)
+        return;
+
+    int bytes = nibbles / 2;
+    for (int i = 0; i < bytes; i++) {
+        uchar byte = (uchar) packed[i];
+        out[2 * i] = QLatin1Char(nibbleChars[byte >> 4]);
+        out[2 * i + 1] = QLatin1Char(nibbleChars[byte & 0x0f]);
+    }
+
+    if (nibbles % 2)
+        out[nibbles - 1] = QLatin1Char(nibbleChars[(uchar) packed[bytes] >> 4]);
+}
+
+char NibbleCodec::at(const char *packed, int i)
+{
+    uchar byte = (uchar) packed[i / 2];
+    return nibbleChars[(i % 2) ? (byte & 0x0f) : (byte >> 4)];
+}
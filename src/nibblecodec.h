@@ -0,0 +1,34 @@
+#ifndef NIBBLECODEC_H
+#define NIBBLECODEC_H
+
+#include <QChar>
+#include <QString>
+
+// The byte count of a nibble string has 7 bits
+#define NIBBLE_MAX_BYTES    0x7f
+#define NIBBLE_MAX_LENGTH   (NIBBLE_MAX_BYTES * 2)
+
+// Packs strings made of digits, '-' and '.' (phone numbers, timestamps,
+// message ids) two characters per byte. Everything is table driven and
+// works in a single pass over caller-provided buffers.
+class NibbleCodec
+{
+public:
+    // Replacement for QRegExp("[0-9.-]"), the characters that can be packed
+    static inline bool isPackable(ushort c)
+    {
+        return (c >= '0' && c <= '9') || c == '-' || c == '.';
+    }
+
+    // Packs length characters into (length + 1) / 2 bytes, returns the
+    // number of bytes written. Every character must pass isPackable() and
+    // length must not exceed NIBBLE_MAX_LENGTH.
+    static int encode(const QChar *string, int length, char *packed);
+
+    static void decode(const char *packed, int nibbles, char *out);
+    static void decode(const char *packed, int nibbles, QChar *out);
+
+    static char at(const char *packed, int i);
+};
+
+#endif // NIBBLECODEC_H
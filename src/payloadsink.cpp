@@ -0,0 +1,57 @@
+#include "payloadsink.h"
+
+/*
+ * DevicePayloadSink
+ */
+
+DevicePayloadSink::DevicePayloadSink(QIODevice *device)
+{
+    this->device = device;
+}
+
+bool DevicePayloadSink::begin(const ProtocolTreeNodeView &node, int size)
+{
+    Q_UNUSED(node);
+    Q_UNUSED(size);
+    return device && device->isWritable();
+}
+
+void DevicePayloadSink::write(const char *data, int length)
+{
+    device->write(data, length);
+}
+
+void DevicePayloadSink::end()
+{
+}
+
+/*
+ * HashPayloadSink
+ */
+
+HashPayloadSink::HashPayloadSink(QCryptographicHash::Algorithm algorithm) : hash(algorithm)
+{
+}
+
+bool HashPayloadSink::begin(const ProtocolTreeNodeView &node, int size)
+{
+    Q_UNUSED(node);
+    Q_UNUSED(size);
+    hash.reset();
+    return true;
+}
+
+void HashPayloadSink::write(const char *data, int length)
+{
+    hash.addData(data, length);
+}
+
+void HashPayloadSink::end()
+{
+    result = hash.result();
+}
+
+QByteArray HashPayloadSink::getResult() const
+{
+    return result;
+}
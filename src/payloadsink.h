@@ -0,0 +1,58 @@
+#ifndef PAYLOADSINK_H
+#define PAYLOADSINK_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QIODevice>
+
+#include "protocoltreenodeview.h"
+
+#define PAYLOADSINK_DEFAULT_THRESHOLD   0x10000
+
+// Receives node payloads above the reader's threshold instead of copying
+// them into the materialized tree. Payloads are delivered once the frame
+// has been authenticated and fully decoded, straight from the receive
+// buffer. Subclass it to get a callback.
+class PayloadSink
+{
+public:
+    virtual ~PayloadSink() {}
+
+    // Returning false leaves the payload in the tree as usual
+    virtual bool begin(const ProtocolTreeNodeView &node, int size) = 0;
+    virtual void write(const char *data, int length) = 0;
+    virtual void end() = 0;
+};
+
+// Writes every payload to a device, e.g. a QFile
+class DevicePayloadSink : public PayloadSink
+{
+public:
+    DevicePayloadSink(QIODevice *device);
+
+    bool begin(const ProtocolTreeNodeView &node, int size);
+    void write(const char *data, int length);
+    void end();
+
+private:
+    QIODevice *device;
+};
+
+// Only keeps a digest of the last payload
+class HashPayloadSink : public PayloadSink
+{
+public:
+    HashPayloadSink(QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha1);
+
+    bool begin(const ProtocolTreeNodeView &node, int size);
+    void write(const char *data, int length);
+    void end();
+
+    QByteArray getResult() const;
+
+private:
+    QCryptographicHash hash;
+    QByteArray result;
+};
+
+#endif // PAYLOADSINK_H
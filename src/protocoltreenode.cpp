@@ -160,7 +160,14 @@ const QString& ProtocolTreeNode::getTag() const
     return tag;
 }
 
-QString ProtocolTreeNode::toString(int depth) const
+static QByteArray dataToHex(const QByteArray &data, int limit)
+{
+    if (limit < 0 || data.length() <= limit)
+        return data.toHex();
+    return data.left(limit).toHex() + "... (" + QByteArray::number(data.length()) + " bytes)";
+}
+
+QString ProtocolTreeNode::toString(int depth, int dataLimit) const
 {
     QString result;
     QTextStream out(&result);
@@ -175,13 +182,13 @@ QString ProtocolTreeNode::toString(int depth) const
         if (data.length() > 0) {
             out << "\n";
             out << QString("").leftJustified((depth + 1) * 4, ' ', false);
-            out << "data:hex:" << data.toHex();
+            out << "data:hex:" << dataToHex(data, dataLimit);
         }
         ProtocolTreeNodeListIterator i(children);
         while (i.hasNext())
         {
             ProtocolTreeNode node = i.next().value();
-            out << node.toString(depth + 1);
+            out << node.toString(depth + 1, dataLimit);
         }
         out << "\n";
         out << QString("").leftJustified(depth * 4, ' ', false);
@@ -192,7 +199,7 @@ QString ProtocolTreeNode::toString(int depth) const
             out << ">";
             out << "\n";
             out << QString("").leftJustified((depth + 1) * 4, ' ', false);
-            out << "data:hex:" << data.toHex();
+            out << "data:hex:" << dataToHex(data, dataLimit);
             out << "\n";
             out << QString("").leftJustified((depth) * 4, ' ', false);
             out << "</" << tag << ">";
@@ -64,7 +64,8 @@ public:
     const AttributeList& getAttributes() const;
     const ProtocolTreeNodeList& getChildren() const;
     ProtocolTreeNode getChild(const QString &tag) const;
-    QString toString(int depth = 0) const;
+    // dataLimit caps the number of data bytes dumped, -1 dumps everything
+    QString toString(int depth = 0, int dataLimit = -1) const;
 
 private:
     QString tag;
@@ -0,0 +1,375 @@
+#include "protocoltreenodeview.h"
+#include "nibblecodec.h"
+
+#include <string.h>
+
+/*
+ * ProtocolTreeNodeIndex
+ */
+
+ProtocolTreeNodeIndex::ProtocolTreeNodeIndex()
+{
+    frame = NULL;
+    frameSize = 0;
+
+    // reserve() keeps the capacity across frames when resized to 0
+    nodes.reserve(64);
+    attributes.reserve(128);
+    strings.reserve(256);
+}
+
+void ProtocolTreeNodeIndex::reset(const char *frame, int frameSize)
+{
+    this->frame = frame;
+    this->frameSize = frameSize;
+
+    nodes.resize(0);
+    attributes.resize(0);
+    strings.resize(0);
+}
+
+int ProtocolTreeNodeIndex::addString(int type, int a, int b)
+{
+    String string;
+    string.type = type;
+    string.a = a;
+    string.b = b;
+    strings.append(string);
+    return strings.size() - 1;
+}
+
+int ProtocolTreeNodeIndex::addNode()
+{
+    Node node;
+    node.tag = -1;
+    node.firstAttribute = attributes.size();
+    node.attributeCount = 0;
+    node.data = -1;
+    node.firstChild = -1;
+    node.childCount = 0;
+    node.next = -1;
+    node.dataStreamed = false;
+    nodes.append(node);
+    return nodes.size() - 1;
+}
+
+QString ProtocolTreeNodeIndex::getString(int string) const
+{
+    if (string < 0)
+        return QString();
+
+    const String &s = strings.at(string);
+    switch (s.type) {
+    case TokenString:
+        return WATokenDictionary::tokenString(s.a);
+    case RawString:
+        return QString::fromUtf8(frame + s.a, s.b);
+    case NibbleString: {
+        QString result;
+        result.resize(s.b);
+        NibbleCodec::decode(frame + s.a, s.b, result.data());
+        return result;
+    }
+    case JidString:
+        if (s.a < 0)
+            return getString(s.b);
+        return getString(s.a) + QLatin1Char('@') + getString(s.b);
+    }
+    return QString();
+}
+
+QByteArray ProtocolTreeNodeIndex::getBytes(int string) const
+{
+    if (string < 0)
+        return QByteArray();
+
+    const String &s = strings.at(string);
+    switch (s.type) {
+    case TokenString:
+        return WATokenDictionary::tokenBytes(s.a);
+    case RawString:
+        return QByteArray(frame + s.a, s.b);
+    case NibbleString: {
+        QByteArray result;
+        result.resize(s.b);
+        NibbleCodec::decode(frame + s.a, s.b, result.data());
+        return result;
+    }
+    default:
+        return getString(string).toUtf8();
+    }
+}
+
+bool ProtocolTreeNodeIndex::stringEquals(int string, const char *value) const
+{
+    if (string < 0)
+        return false;
+
+    const String &s = strings.at(string);
+    switch (s.type) {
+    case TokenString:
+        return qstrcmp(WATokenDictionary::tokenBytes(s.a), value) == 0;
+    case RawString:
+        return (int) strlen(value) == s.b && memcmp(frame + s.a, value, s.b) == 0;
+    case NibbleString: {
+        for (int i = 0; i < s.b; i++) {
+            if (value[i] != NibbleCodec::at(frame + s.a, i))
+                return false;
+        }
+        return value[s.b] == '\0';
+    }
+    default:
+        return getString(string) == QLatin1String(value);
+    }
+}
+
+bool ProtocolTreeNodeIndex::stringEquals(int string, int token) const
+{
+    if (string < 0)
+        return false;
+
+    if (strings.at(string).type == TokenString)
+        return strings.at(string).a == token;
+
+    // Dictionary strings may still be sent spelled out
+    return stringEquals(string, WATokenDictionary::tokenBytes(token).constData());
+}
+
+int ProtocolTreeNodeIndex::getToken(int string) const
+{
+    if (string < 0)
+        return -1;
+
+    const String &s = strings.at(string);
+    if (s.type == TokenString)
+        return s.a;
+
+    // A dictionary word sent spelled out, short enough to look up from
+    // the stack
+    if (s.type != RawString || s.b > 64)
+        return -1;
+
+    QChar chars[64];
+    for (int i = 0; i < s.b; i++) {
+        uchar c = (uchar) frame[s.a + i];
+        if (c >= 0x80)
+            return -1;
+        chars[i] = QChar(c);
+    }
+    return WATokenDictionary::tokenId(chars, s.b);
+}
+
+/*
+ * ProtocolTreeNodeView
+ */
+
+ProtocolTreeNodeView::ProtocolTreeNodeView()
+{
+    index = NULL;
+    node = -1;
+}
+
+ProtocolTreeNodeView::ProtocolTreeNodeView(const ProtocolTreeNodeIndex *index, int node)
+{
+    this->index = index;
+    this->node = node;
+}
+
+bool ProtocolTreeNodeView::isValid() const
+{
+    return index && node >= 0;
+}
+
+QString ProtocolTreeNodeView::getTag() const
+{
+    if (!isValid())
+        return QString();
+    return index->getString(index->nodes.at(node).tag);
+}
+
+bool ProtocolTreeNodeView::hasTag(const char *tag) const
+{
+    return isValid() && index->stringEquals(index->nodes.at(node).tag, tag);
+}
+
+bool ProtocolTreeNodeView::hasTag(int token) const
+{
+    return isValid() && index->stringEquals(index->nodes.at(node).tag, token);
+}
+
+int ProtocolTreeNodeView::getTagToken() const
+{
+    return isValid() ? index->getToken(index->nodes.at(node).tag) : -1;
+}
+
+int ProtocolTreeNodeView::getAttributesCount() const
+{
+    return isValid() ? index->nodes.at(node).attributeCount : 0;
+}
+
+bool ProtocolTreeNodeView::hasAttribute(const char *key) const
+{
+    return findAttribute(key) >= 0;
+}
+
+QString ProtocolTreeNodeView::getAttributeValue(const char *key) const
+{
+    int i = findAttribute(key);
+    if (i < 0)
+        return QString();
+    return index->getString(index->attributes.at(i).value);
+}
+
+bool ProtocolTreeNodeView::hasAttribute(int key) const
+{
+    return findAttribute(key) >= 0;
+}
+
+QString ProtocolTreeNodeView::getAttributeValue(int key) const
+{
+    int i = findAttribute(key);
+    if (i < 0)
+        return QString();
+    return index->getString(index->attributes.at(i).value);
+}
+
+int ProtocolTreeNodeView::getAttributeToken(int key) const
+{
+    int i = findAttribute(key);
+    return i >= 0 ? index->getToken(index->attributes.at(i).value) : -1;
+}
+
+bool ProtocolTreeNodeView::attributeEquals(int key, int value) const
+{
+    int i = findAttribute(key);
+    return i >= 0 && index->stringEquals(index->attributes.at(i).value, value);
+}
+
+int ProtocolTreeNodeView::findAttribute(const char *key) const
+{
+    if (!isValid())
+        return -1;
+
+    const ProtocolTreeNodeIndex::Node &n = index->nodes.at(node);
+    for (int i = n.firstAttribute; i < n.firstAttribute + n.attributeCount; i++) {
+        if (index->stringEquals(index->attributes.at(i).key, key))
+            return i;
+    }
+    return -1;
+}
+
+int ProtocolTreeNodeView::findAttribute(int key) const
+{
+    if (!isValid())
+        return -1;
+
+    const ProtocolTreeNodeIndex::Node &n = index->nodes.at(node);
+    for (int i = n.firstAttribute; i < n.firstAttribute + n.attributeCount; i++) {
+        if (index->stringEquals(index->attributes.at(i).key, key))
+            return i;
+    }
+    return -1;
+}
+
+int ProtocolTreeNodeView::getChildrenCount() const
+{
+    return isValid() ? index->nodes.at(node).childCount : 0;
+}
+
+bool ProtocolTreeNodeView::hasChild(const char *tag) const
+{
+    return getChild(tag).isValid();
+}
+
+ProtocolTreeNodeView ProtocolTreeNodeView::getChild(const char *tag) const
+{
+    ProtocolTreeNodeView child = firstChild();
+    while (child.isValid() && !child.hasTag(tag))
+        child = child.nextSibling();
+    return child;
+}
+
+bool ProtocolTreeNodeView::hasChild(int tag) const
+{
+    return getChild(tag).isValid();
+}
+
+ProtocolTreeNodeView ProtocolTreeNodeView::getChild(int tag) const
+{
+    ProtocolTreeNodeView child = firstChild();
+    while (child.isValid() && !child.hasTag(tag))
+        child = child.nextSibling();
+    return child;
+}
+
+ProtocolTreeNodeView ProtocolTreeNodeView::firstChild() const
+{
+    if (!isValid())
+        return ProtocolTreeNodeView();
+    return ProtocolTreeNodeView(index, index->nodes.at(node).firstChild);
+}
+
+ProtocolTreeNodeView ProtocolTreeNodeView::nextSibling() const
+{
+    if (!isValid())
+        return ProtocolTreeNodeView();
+    return ProtocolTreeNodeView(index, index->nodes.at(node).next);
+}
+
+bool ProtocolTreeNodeView::hasData() const
+{
+    return isValid() && index->nodes.at(node).data >= 0 && !index->nodes.at(node).dataStreamed;
+}
+
+bool ProtocolTreeNodeView::isDataStreamed() const
+{
+    return isValid() && index->nodes.at(node).dataStreamed;
+}
+
+QByteArray ProtocolTreeNodeView::getData() const
+{
+    if (!hasData())
+        return QByteArray();
+    return index->getBytes(index->nodes.at(node).data);
+}
+
+int ProtocolTreeNodeView::getSize() const
+{
+    return isValid() ? index->frameSize : 0;
+}
+
+void ProtocolTreeNodeView::materialize(ProtocolTreeNode &node) const
+{
+    if (!isValid())
+        return;
+
+    const ProtocolTreeNodeIndex::Node &n = index->nodes.at(this->node);
+    node.setTag(index->getString(n.tag));
+    if (this->node == 0)
+        node.setSize(index->frameSize);
+
+    AttributeList attribs;
+    for (int i = n.firstAttribute; i < n.firstAttribute + n.attributeCount; i++) {
+        const ProtocolTreeNodeIndex::Attribute &attribute = index->attributes.at(i);
+        attribs.insert(index->getString(attribute.key), index->getString(attribute.value));
+    }
+    node.setAttributes(attribs);
+
+    if (n.data >= 0 && !n.dataStreamed)
+        node.setData(index->getBytes(n.data));
+
+    ProtocolTreeNodeView child = firstChild();
+    while (child.isValid()) {
+        ProtocolTreeNode childNode;
+        child.materialize(childNode);
+        node.addChild(childNode);
+        child = child.nextSibling();
+    }
+}
+
+ProtocolTreeNode ProtocolTreeNodeView::toProtocolTreeNode() const
+{
+    ProtocolTreeNode result;
+    materialize(result);
+    return result;
+}
@@ -0,0 +1,124 @@
+#ifndef PROTOCOLTREENODEVIEW_H
+#define PROTOCOLTREENODEVIEW_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "protocoltreenode.h"
+#include "watokendictionary.h"
+
+// Index of one decoded frame, built by BinTreeNodeReader in a single pass.
+// Strings are stored as references into the frame and only converted when
+// somebody asks for them. It is only valid until the reader reads the next
+// frame.
+class ProtocolTreeNodeIndex
+{
+public:
+    enum StringType {
+        TokenString,
+        RawString,
+        NibbleString,
+        JidString
+    };
+
+    // TokenString:  a = token id (see WATokenDictionary), b unused
+    // RawString:    a = frame offset, b = length
+    // NibbleString: a = frame offset, b = number of nibbles
+    // JidString:    a = user string (or -1), b = server string
+    struct String {
+        int type;
+        int a;
+        int b;
+    };
+
+    struct Attribute {
+        int key;
+        int value;
+    };
+
+    struct Node {
+        int tag;
+        int firstAttribute;
+        int attributeCount;
+        int data;
+        int firstChild;
+        int childCount;
+        int next;
+        bool dataStreamed;
+    };
+
+    ProtocolTreeNodeIndex();
+
+    void reset(const char *frame, int frameSize);
+
+    int addString(int type, int a, int b);
+    int addNode();
+
+    QString getString(int string) const;
+    QByteArray getBytes(int string) const;
+    bool stringEquals(int string, const char *value) const;
+    bool stringEquals(int string, int token) const;
+    int getToken(int string) const;
+
+    const char *frame;
+    int frameSize;
+
+    QVector<Node> nodes;
+    QVector<Attribute> attributes;
+    QVector<String> strings;
+};
+
+// Lightweight handle on a node of a ProtocolTreeNodeIndex. Looking at the
+// tag or at a few attributes doesn't allocate; toProtocolTreeNode() builds
+// the full tree when a handler needs it. The int overloads take token ids
+// (WATokenDictionary::Token) and compare integers instead of strings.
+class ProtocolTreeNodeView
+{
+public:
+    ProtocolTreeNodeView();
+    ProtocolTreeNodeView(const ProtocolTreeNodeIndex *index, int node);
+
+    bool isValid() const;
+
+    QString getTag() const;
+    bool hasTag(const char *tag) const;
+    bool hasTag(int token) const;
+    int getTagToken() const;
+
+    int getAttributesCount() const;
+    bool hasAttribute(const char *key) const;
+    QString getAttributeValue(const char *key) const;
+    bool hasAttribute(int key) const;
+    QString getAttributeValue(int key) const;
+    bool attributeEquals(int key, int value) const;
+    // Token id of the value, -1 if it isn't a dictionary string
+    int getAttributeToken(int key) const;
+
+    int getChildrenCount() const;
+    bool hasChild(const char *tag) const;
+    ProtocolTreeNodeView getChild(const char *tag) const;
+    bool hasChild(int tag) const;
+    ProtocolTreeNodeView getChild(int tag) const;
+    ProtocolTreeNodeView firstChild() const;
+    ProtocolTreeNodeView nextSibling() const;
+
+    // Payloads handed to a PayloadSink are not part of the tree
+    bool hasData() const;
+    bool isDataStreamed() const;
+    QByteArray getData() const;
+
+    int getSize() const;
+
+    void materialize(ProtocolTreeNode &node) const;
+    ProtocolTreeNode toProtocolTreeNode() const;
+
+private:
+    int findAttribute(const char *key) const;
+    int findAttribute(int key) const;
+
+    const ProtocolTreeNodeIndex *index;
+    int node;
+};
+
+#endif // PROTOCOLTREENODEVIEW_H
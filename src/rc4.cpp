@@ -28,34 +28,38 @@
 
 #include "rc4.h"
 
+#include <string.h>
+
+// One keystream byte into out
+#define RC4_STEP(out)           \
+    si = s[++i];                \
+    j += si;                    \
+    sj = s[j];                  \
+    s[i] = sj;                  \
+    s[j] = si;                  \
+    (out) = s[(quint8) (si + sj)];
+
 RC4::RC4(const QByteArray &key, int drop)
 {
-    i = 0;
+    const uchar *k = (const uchar *) key.constData();
+    int keyLength = key.size();
 
-    while (i < LENGTH)
-    {
-        s[i] = i;
-        i++;
-    }
-    j = 0;
-    i = 0;
+    for (int n = 0; n < LENGTH; n++)
+        s[n] = (quint8) n;
 
-    while (i < LENGTH)
-    {
-        j = (uchar) ((j + s[i]) + key.data()[i % key.size()]);
+    j = 0;
+    for (int n = 0, m = 0; n < LENGTH; n++) {
+        j += s[n] + k[m];
+        if (++m == keyLength)
+            m = 0;
 
-        int tmp = s[i];
-        s[i] = s[j];
+        quint8 tmp = s[n];
+        s[n] = s[j];
         s[j] = tmp;
-
-        i++;
     }
     i = j = 0;
 
-    QByteArray dropArray(drop,0);
-
-    Cipher(dropArray);
-
+    Drop(drop);
 }
 
 void RC4::Cipher(QByteArray data)
@@ -65,16 +69,60 @@ void RC4::Cipher(QByteArray data)
 
 void RC4::Cipher(char *data, int offset, int length)
 {
-    while (length-- != 0)
-    {
-        i = (i + 1) % 0x100;
-        j = (j + s[i]) % 0x100;
+    uchar keystream[RC4_BLOCK_SIZE];
+    data += offset;
 
-        int tmp = s[i];
-        s[i] = s[j];
-        s[j] = tmp;
+    while (length > 0) {
+        int n = qMin(length, RC4_BLOCK_SIZE);
+        generate(keystream, n);
+
+        // memcpy() keeps the word accesses safe for unaligned data, the
+        // compiler turns it into plain loads and stores
+        int k = 0;
+        for (; k + 8 <= n; k += 8) {
+            quint64 word, key;
+            memcpy(&word, data + k, 8);
+            memcpy(&key, keystream + k, 8);
+            word ^= key;
+            memcpy(data + k, &word, 8);
+        }
+        for (; k < n; k++)
+            data[k] ^= keystream[k];
+
+        data += n;
+        length -= n;
+    }
+}
+
+void RC4::Drop(int length)
+{
+    uchar keystream[RC4_BLOCK_SIZE];
 
-        data[offset] = (uchar) (data[offset] ^ ((uchar) s[(s[i] + s[j]) % 0x100]));
-        offset++;
+    while (length > 0) {
+        int n = qMin(length, RC4_BLOCK_SIZE);
+        generate(keystream, n);
+        length -= n;
     }
 }
+
+void RC4::generate(uchar *keystream, int length)
+{
+    // Work on local copies of the indexes so they stay in registers
+    quint8 i = this->i;
+    quint8 j = this->j;
+    quint8 si, sj;
+
+    int n = 0;
+    for (; n + 4 <= length; n += 4) {
+        RC4_STEP(keystream[n])
+        RC4_STEP(keystream[n + 1])
+        RC4_STEP(keystream[n + 2])
+        RC4_STEP(keystream[n + 3])
+    }
+    for (; n < length; n++) {
+        RC4_STEP(keystream[n])
+    }
+
+    this->i = i;
+    this->j = j;
+}
@@ -33,6 +33,10 @@
 
 #define LENGTH      0x100
 
+// Keystream is generated this many bytes ahead and XORed into the data a
+// word at a time
+#define RC4_BLOCK_SIZE  64
+
 class RC4
 {
 public:
@@ -41,10 +45,16 @@ public:
     void Cipher(QByteArray data);
     void Cipher(char *data, int offset, int length);
 
+    // Discards length bytes of keystream
+    void Drop(int length);
+
 private:
-    int i;
-    int j;
-    int s[LENGTH];
+    void generate(uchar *keystream, int length);
+
+    // Byte sized so every index wraps around by itself
+    quint8 i;
+    quint8 j;
+    quint8 s[LENGTH];
 };
 
 #endif // RC4_H
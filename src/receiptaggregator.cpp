@@ -0,0 +1,155 @@
+#include "receiptaggregator.h"
+
+ReceiptAggregator::ReceiptAggregator(BinTreeNodeWriter *out, QIODevice *socket,
+                                     QObject *parent) : QObject(parent)
+{
+    this->out = out;
+    this->socket = socket;
+    window = 0;
+    maxLatency = RECEIPTAGGREGATOR_DEFAULT_MAX_LATENCY;
+    receiptsQueued = 0;
+    receiptFrames = 0;
+    acksQueued = 0;
+
+    windowTimer = new QTimer(this);
+    windowTimer->setSingleShot(true);
+    connect(windowTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+    latencyTimer = new QTimer(this);
+    latencyTimer->setSingleShot(true);
+    connect(latencyTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+void ReceiptAggregator::setWindow(int window, int maxLatency)
+{
+    this->window = window;
+    this->maxLatency = qMax(window, maxLatency);
+    if (window <= 0)
+        flush();
+}
+
+bool ReceiptAggregator::isEnabled() const
+{
+    return window > 0;
+}
+
+bool ReceiptAggregator::addReceipt(const QString &to, const QString &id, const QString &type,
+                                   const QString &participant)
+{
+    if (window <= 0)
+        return false;
+
+    QString key = to + QLatin1Char('\n') + type + QLatin1Char('\n') + participant;
+    QHash<QString, int>::const_iterator i = batchIndex.constFind(key);
+    if (i == batchIndex.constEnd()) {
+        Batch batch;
+        batch.to = to;
+        batch.type = type;
+        batch.participant = participant;
+        batchIndex.insert(key, batches.size());
+        batches.append(batch);
+        i = batchIndex.constFind(key);
+    }
+    batches[i.value()].ids.append(id);
+
+    receiptsQueued++;
+    pending();
+    return true;
+}
+
+bool ReceiptAggregator::addAck(const ProtocolTreeNode &ack)
+{
+    if (window <= 0)
+        return false;
+
+    acks.append(ack);
+
+    acksQueued++;
+    pending();
+    return true;
+}
+
+void ReceiptAggregator::clear()
+{
+    windowTimer->stop();
+    latencyTimer->stop();
+    batches.clear();
+    batchIndex.clear();
+    acks.clear();
+}
+
+qint64 ReceiptAggregator::getReceiptsQueued() const
+{
+    return receiptsQueued;
+}
+
+qint64 ReceiptAggregator::getReceiptFrames() const
+{
+    return receiptFrames;
+}
+
+qint64 ReceiptAggregator::getAcksQueued() const
+{
+    return acksQueued;
+}
+
+void ReceiptAggregator::flush()
+{
+    windowTimer->stop();
+    latencyTimer->stop();
+    if (batches.isEmpty() && acks.isEmpty())
+        return;
+
+    // Like sendRequest(), nothing goes out on a closed socket
+    if (!socket->isOpen()) {
+        clear();
+        return;
+    }
+
+    // Hand the whole burst to the socket at once
+    out->hold();
+
+    foreach (const Batch &batch, batches) {
+        for (int first = 0; first < batch.ids.size(); first += RECEIPTAGGREGATOR_MAX_ITEMS) {
+            int last = qMin(first + RECEIPTAGGREGATOR_MAX_ITEMS, batch.ids.size());
+
+            AttributeList attrs;
+            attrs.insert("to", batch.to);
+            attrs.insert("id", batch.ids.at(first));
+            if (!batch.participant.isEmpty())
+                attrs.insert("participant", batch.participant);
+            if (!batch.type.isEmpty())
+                attrs.insert("type", batch.type);
+            ProtocolTreeNode receiptNode("receipt", attrs);
+
+            if (last - first > 1) {
+                ProtocolTreeNode listNode("list");
+                for (int i = first + 1; i < last; i++) {
+                    AttributeList itemAttrs;
+                    itemAttrs.insert("id", batch.ids.at(i));
+                    listNode.addChild(ProtocolTreeNode("item", itemAttrs));
+                }
+                receiptNode.addChild(listNode);
+            }
+
+            out->write(receiptNode, false);
+            receiptFrames++;
+        }
+    }
+
+    foreach (const ProtocolTreeNode &ack, acks)
+        out->write(ack, false);
+
+    batches.clear();
+    batchIndex.clear();
+    acks.clear();
+
+    out->release();
+}
+
+void ReceiptAggregator::pending()
+{
+    windowTimer->start(window);
+    if (!latencyTimer->isActive())
+        latencyTimer->start(maxLatency);
+}
@@ -0,0 +1,76 @@
+#ifndef RECEIPTAGGREGATOR_H
+#define RECEIPTAGGREGATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QTimer>
+
+#include "protocoltreenode.h"
+#include "bintreenodewriter.h"
+
+#define RECEIPTAGGREGATOR_DEFAULT_MAX_LATENCY   1000
+#define RECEIPTAGGREGATOR_MAX_ITEMS             128
+
+// Batches outgoing delivery/read receipts. Receipts for the same
+// (to, type, participant) are sent as one <receipt> whose first id is an
+// attribute and the rest a <list> of <item>s, like the server sends them.
+// Acks have no list form; they are only held back and written in the same
+// burst. Everything is flushed once no receipt came for the window, and
+// at most maxLatency after the first pending one.
+class ReceiptAggregator : public QObject
+{
+    Q_OBJECT
+
+public:
+    // socket is the device out writes to
+    ReceiptAggregator(BinTreeNodeWriter *out, QIODevice *socket, QObject *parent = 0);
+
+    // window <= 0 disables batching (the default)
+    void setWindow(int window, int maxLatency = RECEIPTAGGREGATOR_DEFAULT_MAX_LATENCY);
+    bool isEnabled() const;
+
+    // Both return false when batching is disabled, the caller sends the
+    // stanza itself then
+    bool addReceipt(const QString &to, const QString &id, const QString &type,
+                    const QString &participant);
+    bool addAck(const ProtocolTreeNode &ack);
+
+    // Drops everything pending, e.g. on disconnection
+    void clear();
+
+    qint64 getReceiptsQueued() const;
+    qint64 getReceiptFrames() const;
+    qint64 getAcksQueued() const;
+
+public slots:
+    void flush();
+
+private:
+    struct Batch {
+        QString to;
+        QString type;
+        QString participant;
+        QStringList ids;
+    };
+
+    void pending();
+
+    BinTreeNodeWriter *out;
+    QIODevice *socket;
+    int window;
+    int maxLatency;
+    QTimer *windowTimer;
+    QTimer *latencyTimer;
+
+    QList<Batch> batches;
+    QHash<QString, int> batchIndex;
+    QList<ProtocolTreeNode> acks;
+
+    qint64 receiptsQueued;
+    qint64 receiptFrames;
+    qint64 acksQueued;
+};
+
+#endif // RECEIPTAGGREGATOR_H
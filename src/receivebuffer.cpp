@@ -0,0 +1,127 @@
+#include "receivebuffer.h"
+
+#include <string.h>
+
+ReceiveBuffer::ReceiveBuffer(int initialCapacity, int limit)
+{
+    this->limit = limit;
+    buffer.resize(qMin(initialCapacity, limit));
+    readOffset = 0;
+    writeOffset = 0;
+    peakSize = 0;
+    reallocations = 0;
+}
+
+qint64 ReceiveBuffer::readFrom(QIODevice *device)
+{
+    qint64 available = device->bytesAvailable();
+    if (available <= 0)
+        return 0;
+
+    int room = limit - size();
+    if (room <= 0)
+        return 0;
+
+    ensureFree((int) qMin(available, (qint64) room));
+
+    qint64 bytesRead = device->read(buffer.data() + writeOffset,
+                                    qMin(buffer.size() - writeOffset, room));
+    if (bytesRead > 0) {
+        writeOffset += bytesRead;
+        if (size() > peakSize)
+            peakSize = size();
+    }
+    return bytesRead;
+}
+
+bool ReceiveBuffer::reserve(int size)
+{
+    if (size <= this->size())
+        return true;
+    return ensureFree(size - this->size());
+}
+
+void ReceiveBuffer::consume(int bytes)
+{
+    readOffset += qMin(bytes, size());
+    if (readOffset == writeOffset) {
+        readOffset = 0;
+        writeOffset = 0;
+    }
+}
+
+void ReceiveBuffer::clear()
+{
+    readOffset = 0;
+    writeOffset = 0;
+}
+
+char *ReceiveBuffer::data()
+{
+    return buffer.data() + readOffset;
+}
+
+const char *ReceiveBuffer::constData() const
+{
+    return buffer.constData() + readOffset;
+}
+
+int ReceiveBuffer::size() const
+{
+    return writeOffset - readOffset;
+}
+
+void ReceiveBuffer::setLimit(int limit)
+{
+    this->limit = limit;
+}
+
+int ReceiveBuffer::getLimit() const
+{
+    return limit;
+}
+
+int ReceiveBuffer::getCapacity() const
+{
+    return buffer.size();
+}
+
+int ReceiveBuffer::getPeakSize() const
+{
+    return peakSize;
+}
+
+int ReceiveBuffer::getReallocations() const
+{
+    return reallocations;
+}
+
+void ReceiveBuffer::compact()
+{
+    if (readOffset == 0)
+        return;
+
+    char *base = buffer.data();
+    memmove(base, base + readOffset, size());
+    writeOffset -= readOffset;
+    readOffset = 0;
+}
+
+bool ReceiveBuffer::ensureFree(int bytes)
+{
+    if (buffer.size() - writeOffset >= bytes)
+        return true;
+
+    compact();
+    if (buffer.size() - writeOffset >= bytes)
+        return true;
+
+    int needed = writeOffset + bytes;
+    if (needed > limit)
+        return false;
+
+    // Grow geometrically so a burst settles on its high-water mark quickly
+    buffer.resize(qMin(qMax(buffer.size() * 2, needed), limit));
+    reallocations++;
+    return true;
+}
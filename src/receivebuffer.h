@@ -0,0 +1,52 @@
+#ifndef RECEIVEBUFFER_H
+#define RECEIVEBUFFER_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+#define RECEIVEBUFFER_INITIAL_CAPACITY  0x4000
+#define RECEIVEBUFFER_DEFAULT_LIMIT     0x200000
+
+// Per-connection receive buffer. Unread bytes are moved back to the front
+// instead of wrapping around, so a whole frame is always contiguous and can
+// be decrypted in place. Capacity only grows (up to the limit) and is kept
+// across frames and reconnections, so steady-state reads don't allocate.
+class ReceiveBuffer
+{
+public:
+    ReceiveBuffer(int initialCapacity = RECEIVEBUFFER_INITIAL_CAPACITY,
+                  int limit = RECEIVEBUFFER_DEFAULT_LIMIT);
+
+    // Reads as much as the device has buffered, bounded by the limit.
+    // Returns the number of bytes read or -1 on device error.
+    qint64 readFrom(QIODevice *device);
+
+    // Makes sure size bytes fit in the buffer, false if above the limit
+    bool reserve(int size);
+    void consume(int bytes);
+    void clear();
+
+    char *data();
+    const char *constData() const;
+    int size() const;
+
+    void setLimit(int limit);
+    int getLimit() const;
+    int getCapacity() const;
+    int getPeakSize() const;
+    int getReallocations() const;
+
+private:
+    void compact();
+    bool ensureFree(int bytes);
+
+    QByteArray buffer;
+    int readOffset;
+    int writeOffset;
+    int limit;
+
+    int peakSize;
+    int reallocations;
+};
+
+#endif // RECEIVEBUFFER_H
@@ -0,0 +1,129 @@
+#include "replytable.h"
+
+ReplyTable::ReplyTable(int types, QObject *parent) : QObject(parent)
+{
+    Latency empty;
+    empty.replies = 0;
+    empty.expired = 0;
+    empty.total = 0;
+    empty.max = 0;
+    latencies.fill(empty, types);
+
+    clock.start();
+
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, SIGNAL(timeout()), this, SLOT(expire()));
+}
+
+void ReplyTable::insert(const QString &id, int type, int timeout)
+{
+    QHash<QString, Request>::iterator i = requests.find(id);
+    if (i != requests.end())
+        removeDeadline(id, i.value().deadline);
+
+    Request request;
+    request.type = type;
+    request.sent = clock.elapsed();
+    request.deadline = request.sent + timeout;
+    requests.insert(id, request);
+    deadlines.insert(request.deadline, id);
+
+    // Only an earlier deadline than the armed one moves the timer
+    if (deadlines.begin().key() == request.deadline)
+        schedule();
+}
+
+int ReplyTable::take(const QString &id)
+{
+    QHash<QString, Request>::iterator i = requests.find(id);
+    if (i == requests.end())
+        return -1;
+
+    Request request = i.value();
+    requests.erase(i);
+    removeDeadline(id, request.deadline);
+
+    // The timer is left alone, firing early just arms it again
+    qint64 latency = clock.elapsed() - request.sent;
+    Latency &stats = latencies[request.type];
+    stats.replies++;
+    stats.total += latency;
+    stats.max = qMax(stats.max, latency);
+
+    return request.type;
+}
+
+void ReplyTable::clear()
+{
+    requests.clear();
+    deadlines.clear();
+    timer->stop();
+}
+
+int ReplyTable::size() const
+{
+    return requests.size();
+}
+
+qint64 ReplyTable::getReplies(int type) const
+{
+    return latencies.at(type).replies;
+}
+
+qint64 ReplyTable::getExpired(int type) const
+{
+    return latencies.at(type).expired;
+}
+
+double ReplyTable::getAverageLatency(int type) const
+{
+    const Latency &stats = latencies.at(type);
+    return stats.replies > 0 ? (double) stats.total / stats.replies : 0.0;
+}
+
+qint64 ReplyTable::getMaxLatency(int type) const
+{
+    return latencies.at(type).max;
+}
+
+void ReplyTable::expire()
+{
+    qint64 now = clock.elapsed();
+
+    // Handlers may send new requests, so start over from the earliest
+    // deadline every time
+    while (!deadlines.isEmpty() && deadlines.begin().key() <= now) {
+        QString id = deadlines.begin().value();
+        deadlines.erase(deadlines.begin());
+
+        int type = requests.take(id).type;
+        latencies[type].expired++;
+        Q_EMIT expired(id, type);
+    }
+
+    schedule();
+}
+
+void ReplyTable::removeDeadline(const QString &id, qint64 deadline)
+{
+    QMultiMap<qint64, QString>::iterator i = deadlines.find(deadline);
+    while (i != deadlines.end() && i.key() == deadline) {
+        if (i.value() == id) {
+            deadlines.erase(i);
+            return;
+        }
+        ++i;
+    }
+}
+
+void ReplyTable::schedule()
+{
+    if (deadlines.isEmpty()) {
+        timer->stop();
+        return;
+    }
+
+    qint64 wait = deadlines.begin().key() - clock.elapsed();
+    timer->start((int) qMax(wait, (qint64) 0));
+}
@@ -0,0 +1,70 @@
+#ifndef REPLYTABLE_H
+#define REPLYTABLE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+// Outstanding requests by stanza id. Every request has a type (an index
+// the owner maps to its handlers) and a deadline; a single timer armed for
+// the earliest deadline expires them, so requests whose reply never
+// arrives don't stay around. Send to reply latency is kept per type.
+class ReplyTable : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ReplyTable(int types, QObject *parent = 0);
+
+    // A request already waiting with the same id is replaced
+    void insert(const QString &id, int type, int timeout);
+
+    // Type of the request waiting for this reply, -1 if there is none.
+    // The request is removed and its latency recorded.
+    int take(const QString &id);
+
+    // Drops every waiting request without expiring them, the statistics
+    // are kept
+    void clear();
+    int size() const;
+
+    qint64 getReplies(int type) const;
+    qint64 getExpired(int type) const;
+    double getAverageLatency(int type) const;
+    qint64 getMaxLatency(int type) const;
+
+signals:
+    void expired(const QString &id, int type);
+
+private slots:
+    void expire();
+
+private:
+    struct Request {
+        int type;
+        qint64 sent;
+        qint64 deadline;
+    };
+
+    struct Latency {
+        qint64 replies;
+        qint64 expired;
+        qint64 total;
+        qint64 max;
+    };
+
+    void removeDeadline(const QString &id, qint64 deadline);
+    void schedule();
+
+    QHash<QString, Request> requests;
+    QMultiMap<qint64, QString> deadlines;
+    QVector<Latency> latencies;
+    QElapsedTimer clock;
+    QTimer *timer;
+};
+
+#endif // REPLYTABLE_H
@@ -0,0 +1,241 @@
+#include "sha1.h"
+#include "sha1_p.h"
+
+#include <QAtomicInt>
+#include <QDebug>
+
+#include <string.h>
+
+#define ROL(x, n)   SHA1_ROL(x, n)
+
+// Backend in use. Constant initialized, so a hash computed by another
+// static initializer before initialBackend is set up uses the portable
+// code. Only accessed atomically; the function table itself is constant.
+static QBasicAtomicInt currentBackend = Q_BASIC_ATOMIC_INITIALIZER(Sha1::Portable);
+
+static inline int loadBackend()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+    return currentBackend.load();
+#else
+    return currentBackend;
+#endif
+}
+
+const Sha1::Backend Sha1::initialBackend = Sha1::selectBackend();
+
+Sha1::Sha1()
+{
+    reset();
+}
+
+void Sha1::reset()
+{
+    state[0] = 0x67452301;
+    state[1] = 0xefcdab89;
+    state[2] = 0x98badcfe;
+    state[3] = 0x10325476;
+    state[4] = 0xc3d2e1f0;
+    length = 0;
+    buffered = 0;
+}
+
+void Sha1::update(const char *data, int length)
+{
+    const uchar *in = (const uchar *) data;
+    this->length += length;
+
+    if (buffered > 0) {
+        int n = qMin(length, SHA1_BLOCK_SIZE - buffered);
+        memcpy(buffer + buffered, in, n);
+        buffered += n;
+        in += n;
+        length -= n;
+        if (buffered < SHA1_BLOCK_SIZE)
+            return;
+        compress(state, buffer, 1);
+        buffered = 0;
+    }
+
+    // Whole blocks straight from the input
+    int blocks = length / SHA1_BLOCK_SIZE;
+    if (blocks > 0) {
+        compress(state, in, blocks);
+        in += blocks * SHA1_BLOCK_SIZE;
+        length -= blocks * SHA1_BLOCK_SIZE;
+    }
+
+    memcpy(buffer, in, length);
+    buffered = length;
+}
+
+void Sha1::final(char *digest)
+{
+    quint64 bits = length * 8;
+
+    buffer[buffered++] = 0x80;
+    if (buffered > SHA1_BLOCK_SIZE - 8) {
+        memset(buffer + buffered, 0, SHA1_BLOCK_SIZE - buffered);
+        compress(state, buffer, 1);
+        buffered = 0;
+    }
+    memset(buffer + buffered, 0, SHA1_BLOCK_SIZE - 8 - buffered);
+    for (int i = 0; i < 8; i++)
+        buffer[SHA1_BLOCK_SIZE - 1 - i] = (uchar) (bits >> (8 * i));
+    compress(state, buffer, 1);
+
+    for (int i = 0; i < 5; i++) {
+        digest[4 * i] = (char) (state[i] >> 24);
+        digest[4 * i + 1] = (char) (state[i] >> 16);
+        digest[4 * i + 2] = (char) (state[i] >> 8);
+        digest[4 * i + 3] = (char) state[i];
+    }
+}
+
+void Sha1::hash(const char *data, int length, char *digest)
+{
+    Sha1 sha1;
+    sha1.update(data, length);
+    sha1.final(digest);
+}
+
+Sha1::Backend Sha1::getBackend()
+{
+    return (Backend) loadBackend();
+}
+
+const char *Sha1::getBackendName(Backend backend)
+{
+    switch (backend) {
+    case Portable:
+        return "portable";
+    case Ssse3:
+        return "ssse3";
+    case ShaNi:
+        return "sha-ni";
+    default:
+        return "unknown";
+    }
+}
+
+bool Sha1::isSupported(Backend backend)
+{
+    switch (backend) {
+    case Portable:
+        return true;
+#ifdef SHA1_X86
+    case Ssse3:
+        return sha1CpuHasSsse3();
+    case ShaNi:
+        return sha1CpuHasShaNi();
+#endif
+    default:
+        return false;
+    }
+}
+
+bool Sha1::setBackend(Backend backend)
+{
+    if (!isSupported(backend))
+        return false;
+
+    currentBackend.fetchAndStoreOrdered(backend);
+    return true;
+}
+
+void Sha1::compress(quint32 *state, const uchar *blocks, int count)
+{
+    compressFunction((Backend) loadBackend())(state, blocks, count);
+}
+
+Sha1::CompressFunction Sha1::compressFunction(Backend backend)
+{
+    switch (backend) {
+#ifdef SHA1_X86
+    case Ssse3:
+        return sha1CompressSsse3;
+    case ShaNi:
+        return sha1CompressShaNi;
+#endif
+    default:
+        return compressPortable;
+    }
+}
+
+// Switches to the fastest supported backend that agrees with the portable
+// one on a few messages covering one and several blocks
+Sha1::Backend Sha1::selectBackend()
+{
+    uchar message[4 * SHA1_BLOCK_SIZE];
+    for (int i = 0; i < (int) sizeof(message); i++)
+        message[i] = (uchar) (i * 167 + 13);
+
+    quint32 expected[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    compressPortable(expected, message, 4);
+
+    for (int candidate = BackendCount - 1; candidate > Portable; candidate--) {
+        if (!isSupported((Backend) candidate))
+            continue;
+
+        CompressFunction function = compressFunction((Backend) candidate);
+        quint32 result[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+        function(result, message, 1);
+        function(result, message + SHA1_BLOCK_SIZE, 3);
+
+        if (memcmp(result, expected, sizeof(expected)) == 0) {
+            currentBackend.fetchAndStoreOrdered(candidate);
+            return (Backend) candidate;
+        }
+
+        qWarning() << "Sha1: the" << getBackendName((Backend) candidate)
+                   << "backend gives wrong results, not using it";
+    }
+
+    return Portable;
+}
+
+void Sha1::compressPortable(quint32 *state, const uchar *blocks, int count)
+{
+    quint32 w[80];
+
+    while (count-- > 0) {
+        for (int t = 0; t < 16; t++) {
+            w[t] = ((quint32) blocks[4 * t] << 24) | ((quint32) blocks[4 * t + 1] << 16)
+                    | ((quint32) blocks[4 * t + 2] << 8) | (quint32) blocks[4 * t + 3];
+        }
+        for (int t = 16; t < 80; t++)
+            w[t] = ROL(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+
+        quint32 a = state[0];
+        quint32 b = state[1];
+        quint32 c = state[2];
+        quint32 d = state[3];
+        quint32 e = state[4];
+        quint32 tmp;
+
+        for (int t = 0; t < 20; t++) {
+            tmp = ROL(a, 5) + ((b & c) | (~b & d)) + e + w[t] + SHA1_K0;
+            e = d; d = c; c = ROL(b, 30); b = a; a = tmp;
+        }
+        for (int t = 20; t < 40; t++) {
+            tmp = ROL(a, 5) + (b ^ c ^ d) + e + w[t] + SHA1_K1;
+            e = d; d = c; c = ROL(b, 30); b = a; a = tmp;
+        }
+        for (int t = 40; t < 60; t++) {
+            tmp = ROL(a, 5) + ((b & c) | (b & d) | (c & d)) + e + w[t] + SHA1_K2;
+            e = d; d = c; c = ROL(b, 30); b = a; a = tmp;
+        }
+        for (int t = 60; t < 80; t++) {
+            tmp = ROL(a, 5) + (b ^ c ^ d) + e + w[t] + SHA1_K3;
+            e = d; d = c; c = ROL(b, 30); b = a; a = tmp;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+
+        blocks += SHA1_BLOCK_SIZE;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <QtGlobal>
+
+#define SHA1_DIGEST_SIZE    20
+#define SHA1_BLOCK_SIZE     64
+
+// Incremental SHA-1. The context is a plain value: copying it forks the
+// hash state, which HmacSha1 uses to start every message from the
+// precomputed key pads.
+//
+// The block function has several backends. The fastest one the CPU
+// supports is picked on first use; every candidate is checked against the
+// portable one before it is enabled.
+class Sha1
+{
+public:
+    enum Backend {
+        Portable,   // plain C++
+        Ssse3,      // SSSE3 message schedule, scalar rounds
+        ShaNi,      // x86 SHA extensions
+        BackendCount
+    };
+
+    Sha1();
+
+    void reset();
+    void update(const char *data, int length);
+    void final(char *digest);
+
+    static void hash(const char *data, int length, char *digest);
+
+    static Backend getBackend();
+    static const char *getBackendName(Backend backend);
+    static bool isSupported(Backend backend);
+
+    // Forces a backend, mostly for benchmarks and cross checks. Returns
+    // false and keeps the current one if the CPU doesn't support it.
+    // Safe while other threads are hashing.
+    static bool setBackend(Backend backend);
+
+private:
+    typedef void (*CompressFunction)(quint32 *state, const uchar *blocks, int count);
+
+    static void compress(quint32 *state, const uchar *blocks, int count);
+    static void compressPortable(quint32 *state, const uchar *blocks, int count);
+    static CompressFunction compressFunction(Backend backend);
+    static Backend selectBackend();
+
+    // Set up while the library is loaded, before other threads exist
+    static const Backend initialBackend;
+
+    quint32 state[5];
+    quint64 length;
+    uchar buffer[SHA1_BLOCK_SIZE];
+    int buffered;
+};
+
+#endif // SHA1_H
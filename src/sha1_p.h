@@ -0,0 +1,30 @@
+#ifndef SHA1_P_H
+#define SHA1_P_H
+
+#include <QtGlobal>
+
+// The x86 backends need the target attribute to build the SIMD code
+// without compiling the whole library for a newer CPU
+#if (defined(__x86_64__) || defined(__i386__)) \
+        && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define SHA1_X86
+#endif
+
+// Round constants
+#define SHA1_K0     0x5a827999
+#define SHA1_K1     0x6ed9eba1
+#define SHA1_K2     0x8f1bbcdc
+#define SHA1_K3     0xca62c1d6
+
+#define SHA1_ROL(x, n)  (((x) << (n)) | ((x) >> (32 - (n))))
+
+#ifdef SHA1_X86
+// CPUID feature bits
+bool sha1CpuHasSsse3();
+bool sha1CpuHasShaNi();
+
+void sha1CompressSsse3(quint32 *state, const uchar *blocks, int count);
+void sha1CompressShaNi(quint32 *state, const uchar *blocks, int count);
+#endif
+
+#endif // SHA1_P_H
@@ -0,0 +1,161 @@
+#include "sha1_p.h"
+
+#ifdef SHA1_X86
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA1_SSSE3  __attribute__((target("ssse3")))
+#define SHA1_SHANI  __attribute__((target("sha,ssse3")))
+
+#define CPUID1_ECX_SSSE3    (1 << 9)
+#define CPUID7_EBX_SHA      (1 << 29)
+
+bool sha1CpuHasSsse3()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (ecx & CPUID1_ECX_SSSE3) != 0;
+}
+
+bool sha1CpuHasShaNi()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!sha1CpuHasSsse3() || __get_cpuid_max(0, 0) < 7)
+        return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & CPUID7_EBX_SHA) != 0;
+}
+
+// Next 4 schedule words W[t..t+3] from the previous 16, held in 4 vectors
+// of 4 words. W[t+3] depends on W[t], so that lane is computed without
+// it first and fixed up: with x0 the lane 0 input, W[t] == ROL1(x0) and
+// ROL1(x ^ W[t]) == ROL1(x) ^ ROL2(x0).
+static inline SHA1_SSSE3 __m128i scheduleSsse3(__m128i w16, __m128i w12, __m128i w8,
+                                                  __m128i w4)
+{
+    __m128i x = _mm_xor_si128(w16, _mm_alignr_epi8(w12, w16, 8));  // W[t-16], W[t-14]
+    x = _mm_xor_si128(x, w8);                                       // W[t-8]
+    x = _mm_xor_si128(x, _mm_srli_si128(w4, 4));                    // W[t-3], 0 for the last lane
+
+    __m128i w = _mm_or_si128(_mm_slli_epi32(x, 1), _mm_srli_epi32(x, 31));
+    __m128i fix = _mm_slli_si128(x, 12);
+    fix = _mm_or_si128(_mm_slli_epi32(fix, 2), _mm_srli_epi32(fix, 30));
+    return _mm_xor_si128(w, fix);
+}
+
+// The message schedule is computed 4 words at a time and stored with the
+// round constants already added; the rounds themselves stay scalar
+SHA1_SSSE3 void sha1CompressSsse3(quint32 *state, const uchar *blocks, int count)
+{
+    const __m128i swap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    const __m128i k[4] = {
+        _mm_set1_epi32(SHA1_K0), _mm_set1_epi32(SHA1_K1),
+        _mm_set1_epi32(SHA1_K2), _mm_set1_epi32(SHA1_K3)
+    };
+    quint32 wk[80];
+
+    while (count-- > 0) {
+        __m128i w[20];
+        for (int i = 0; i < 4; i++) {
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (blocks + 16 * i)), swap);
+            _mm_storeu_si128((__m128i *) (wk + 4 * i), _mm_add_epi32(w[i], k[0]));
+        }
+        for (int i = 4; i < 20; i++) {
+            w[i] = scheduleSsse3(w[i - 4], w[i - 3], w[i - 2], w[i - 1]);
+            _mm_storeu_si128((__m128i *) (wk + 4 * i), _mm_add_epi32(w[i], k[i / 5]));
+        }
+
+        quint32 a = state[0];
+        quint32 b = state[1];
+        quint32 c = state[2];
+        quint32 d = state[3];
+        quint32 e = state[4];
+        quint32 tmp;
+
+        for (int t = 0; t < 20; t++) {
+            tmp = SHA1_ROL(a, 5) + (d ^ (b & (c ^ d))) + e + wk[t];
+            e = d; d = c; c = SHA1_ROL(b, 30); b = a; a = tmp;
+        }
+        for (int t = 20; t < 40; t++) {
+            tmp = SHA1_ROL(a, 5) + (b ^ c ^ d) + e + wk[t];
+            e = d; d = c; c = SHA1_ROL(b, 30); b = a; a = tmp;
+        }
+        for (int t = 40; t < 60; t++) {
+            tmp = SHA1_ROL(a, 5) + ((b & c) | (d & (b | c))) + e + wk[t];
+            e = d; d = c; c = SHA1_ROL(b, 30); b = a; a = tmp;
+        }
+        for (int t = 60; t < 80; t++) {
+            tmp = SHA1_ROL(a, 5) + (b ^ c ^ d) + e + wk[t];
+            e = d; d = c; c = SHA1_ROL(b, 30); b = a; a = tmp;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+
+        blocks += 64;
+    }
+}
+
+// Four rounds of group g (rounds 4g..4g+3) with round function f. m[g % 4]
+// holds W[4g..4g+3]; the later words are prepared with msg1/xor/msg2 as
+// soon as their inputs are available. prev is ABCD before the previous
+// group, sha1nexte derives this group's E from it. Both arguments are
+// constants so the conditions fold away and m[] stays in registers.
+#define SHA1_NI_GROUP(g, f)                                                 \
+    e = _mm_sha1nexte_epu32(prev, m[(g) & 3]);                              \
+    prev = abcd;                                                            \
+    if ((g) >= 3 && (g) <= 18)                                              \
+        m[((g) + 1) & 3] = _mm_sha1msg2_epu32(m[((g) + 1) & 3], m[(g) & 3]); \
+    abcd = _mm_sha1rnds4_epu32(abcd, e, f);                                 \
+    if ((g) <= 16)                                                          \
+        m[((g) - 1) & 3] = _mm_sha1msg1_epu32(m[((g) - 1) & 3], m[(g) & 3]); \
+    if ((g) >= 2 && (g) <= 17)                                              \
+        m[((g) - 2) & 3] = _mm_xor_si128(m[((g) - 2) & 3], m[(g) & 3]);
+
+SHA1_SHANI void sha1CompressShaNi(quint32 *state, const uchar *blocks, int count)
+{
+    // The instructions keep A in the highest lane and the message words
+    // in reverse order: byte swap the whole vector
+    const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0x1b);
+    __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+    while (count-- > 0) {
+        __m128i abcdStart = abcd;
+        __m128i eStart = e0;
+        __m128i m[4];
+        __m128i e, prev;
+
+        for (int i = 0; i < 4; i++)
+            m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (blocks + 16 * i)), swap);
+
+        // The first group takes E directly
+        e = _mm_add_epi32(e0, m[0]);
+        prev = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+
+        SHA1_NI_GROUP(1, 0)  SHA1_NI_GROUP(2, 0)  SHA1_NI_GROUP(3, 0)  SHA1_NI_GROUP(4, 0)
+        SHA1_NI_GROUP(5, 1)  SHA1_NI_GROUP(6, 1)  SHA1_NI_GROUP(7, 1)  SHA1_NI_GROUP(8, 1)
+        SHA1_NI_GROUP(9, 1)  SHA1_NI_GROUP(10, 2) SHA1_NI_GROUP(11, 2) SHA1_NI_GROUP(12, 2)
+        SHA1_NI_GROUP(13, 2) SHA1_NI_GROUP(14, 2) SHA1_NI_GROUP(15, 3) SHA1_NI_GROUP(16, 3)
+        SHA1_NI_GROUP(17, 3) SHA1_NI_GROUP(18, 3) SHA1_NI_GROUP(19, 3)
+
+        e0 = _mm_sha1nexte_epu32(prev, eStart);
+        abcd = _mm_add_epi32(abcd, abcdStart);
+
+        blocks += 64;
+    }
+
+    quint32 e4[4];
+    _mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1b));
+    _mm_storeu_si128((__m128i *) e4, e0);
+    state[4] = e4[3];
+}
+
+#endif // SHA1_X86
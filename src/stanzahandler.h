@@ -0,0 +1,18 @@
+#ifndef STANZAHANDLER_H
+#define STANZAHANDLER_H
+
+#include "protocoltreenode.h"
+
+// Gets the incoming stanzas WAConnection doesn't handle itself, see
+// WAConnection::addStanzaHandler(). Called from the thread running the
+// connection.
+class StanzaHandler
+{
+public:
+    virtual ~StanzaHandler() {}
+
+    // Returning false passes the stanza on to the next handler
+    virtual bool handleStanza(const ProtocolTreeNode &node) = 0;
+};
+
+#endif // STANZAHANDLER_H
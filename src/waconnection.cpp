@@ -2,6 +2,7 @@
 #include "waconnection_p.h"
 #include "waconstants.h"
 #include "protocoltreenodelistiterator.h"
+#include "walog.h"
 
 #include "../libaxolotl/util/keyhelper.h"
 #include "../libaxolotl/protocol/prekeywhispermessage.h"
@@ -19,14 +20,45 @@
 WAConnectionPrivate::WAConnectionPrivate(WAConnection *q):
     QObject(q),
     q_ptr(q),
+    m_storeConnection(AXOLOTL_DB_CONNECTION),
+    m_payloadSink(NULL),
+    m_payloadThreshold(PAYLOADSINK_DEFAULT_THRESHOLD),
+    m_writeCoalescing(false),
+    m_receiptWindow(0),
+    m_receiptMaxLatency(RECEIPTAGGREGATOR_DEFAULT_MAX_LATENCY),
     m_isReading(false),
-    m_passive(false),
+    m_authFailed(false),
+    replies(NULL),
+    receipts(NULL),
+    socket(NULL),
+    dict(NULL),
+    out(NULL),
+    in(NULL),
     m_passiveCount(0),
     m_passiveGroups(false),
     m_passiveReconnect(false),
-    m_authFailed(false)
-{
-}
+    m_passive(false)
+{
+}
+
+const WAConnectionPrivate::ReplyInfo WAConnectionPrivate::replyHandlers[ReplyTypeCount] = {
+    { "serverProperties", &WAConnectionPrivate::connectionServerProperties, NULL, 60000 },
+    { "pong", &WAConnectionPrivate::onPong, &WAConnectionPrivate::pingExpired, 30000 },
+    { "lastSeen", &WAConnectionPrivate::contactLastSeen, NULL, 60000 },
+    { "statuses", &WAConnectionPrivate::contactsStatuses, NULL, 60000 },
+    { "picture", &WAConnectionPrivate::contactPicture, NULL, 120000 },
+    { "pictureIds", &WAConnectionPrivate::contactsPicrureIds, NULL, 60000 },
+    { "privacyList", &WAConnectionPrivate::privacyList, NULL, 60000 },
+    { "pushConfig", &WAConnectionPrivate::pushConfig, NULL, 60000 },
+    { "messageSent", &WAConnectionPrivate::messageSent, NULL, 120000 },
+    { "sync", &WAConnectionPrivate::syncResponse, NULL, 120000 },
+    { "features", &WAConnectionPrivate::featureResponse, NULL, 60000 },
+    { "groups", &WAConnectionPrivate::groupsResponse, NULL, 60000 },
+    { "broadcasts", &WAConnectionPrivate::broadcastsResponse, NULL, 60000 },
+    { "passive", &WAConnectionPrivate::passiveResponse, NULL, 60000 },
+    { "encrypt", &WAConnectionPrivate::encryptionReply, NULL, 120000 },
+    { "getKeys", &WAConnectionPrivate::getKeysReponse, NULL, 60000 }
+};
 
 void WAConnectionPrivate::init()
 {
@@ -35,28 +67,60 @@ void WAConnectionPrivate::init()
     dict = new WATokenDictionary(this);
     out = new BinTreeNodeWriter(socket, dict, this);
     in = new BinTreeNodeReader(socket, dict, this);
+    replies = new ReplyTable(ReplyTypeCount, this);
+    receipts = new ReceiptAggregator(out, socket, this);
+    connect(replies, SIGNAL(expired(QString,int)), this, SLOT(replyExpired(QString,int)));
+
+    // Settings made before init()
+    in->setPayloadSink(m_payloadSink, m_payloadThreshold);
+    foreach (const StanzaFilterTokens &filter, m_stanzaFilters)
+        in->addStanzaFilter(filter.tag, filter.attribute, filter.value);
+    out->setCoalescing(m_writeCoalescing);
+    receipts->setWindow(m_receiptWindow, m_receiptMaxLatency);
+
     iqid = 0;
     mseq = 0;
     sessionTime = QDateTime::currentDateTime().toTime_t();
 
-    QSharedPointer<LiteAxolotlStore> tmpStore(new LiteAxolotlStore(AXOLOTL_DB_CONNECTION));
+    QSharedPointer<LiteAxolotlStore> tmpStore(new LiteAxolotlStore(m_storeConnection));
     axolotlStore.swap(tmpStore);
 
-    q_ptr->m_connectionStatus = WAConnection::Disconnected;
-    Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+    setConnectionStatus(WAConnection::Disconnected);
+}
+
+// Runs in the network thread and returns only once nothing can reach
+// q_ptr anymore
+void WAConnectionPrivate::dispose()
+{
+    delete this;
 }
 
 void WAConnectionPrivate::readNode()
 {
-    while (socket->state() == QAbstractSocket::ConnectedState && socket->bytesAvailable() > 0) {
-        if (!read())
-            qDebug() << "Error reading tree";
+    if (m_isReading)
+        return;
+
+    m_isReading = true;
+    // Handle every stanza already buffered; a partial frame stays in the
+    // reader until the next readyRead(). A frame that fails to decode is
+    // skipped, the ones behind it won't get another readyRead().
+    while (socket->state() == QAbstractSocket::ConnectedState) {
+        if (!read()) {
+            if (in->isWaitingForData())
+                break;
+            WA_LOG(WALogNetwork, WALogWarning) << "Error reading tree";
+        }
     }
+    m_isReading = false;
 }
 
 void WAConnectionPrivate::login(const QVariantMap &loginData)
 {
-    if (q_ptr->m_connectionStatus > WAConnection::Disconnected) {
+    if (!socket) {
+        qWarning() << "WAConnection::login() called before init()";
+        return;
+    }
+    if (q_ptr->getConnectionStatus() > WAConnection::Disconnected) {
         return;
     }
 
@@ -77,8 +141,11 @@ void WAConnectionPrivate::login(const QVariantMap &loginData)
     axolotlStore->setDatabaseName(database);
     m_servers = loginData["servers"].toStringList();
     m_passive = loginData["passive"].toBool();
+    if (loginData.contains("receiveBufferLimit")) {
+        in->setReceiveBufferLimit(loginData["receiveBufferLimit"].toInt());
+    }
     if (m_passive) {
-        qDebug() << "PASSIVE LOGIN!";
+        WA_LOG(WALogConnection, WALogInfo) << "PASSIVE LOGIN!";
     }
 
     loginInternal();
@@ -86,7 +153,10 @@ void WAConnectionPrivate::login(const QVariantMap &loginData)
 
 void WAConnectionPrivate::logout()
 {
-    if (q_ptr->m_connectionStatus >= WAConnection::Initiaization) {
+    if (!socket)
+        return;
+    if (q_ptr->getConnectionStatus() >= WAConnection::Initiaization) {
+        receipts->flush();
         sendSetPresence(false);
         out->streamEnd();
     }
@@ -115,7 +185,7 @@ void WAConnectionPrivate::sendGetProperties()
     ProtocolTreeNode propsNode("props");
     iqNode.addChild(propsNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(connectionServerProperties));
+    int bytes = sendRequest(iqNode, ReplyServerProperties);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -132,7 +202,7 @@ void WAConnectionPrivate::sendPing()
     ProtocolTreeNode pingNode("ping");
     iqNode.addChild(pingNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(onPong));
+    int bytes = sendRequest(iqNode, ReplyPong);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -152,7 +222,7 @@ void WAConnectionPrivate::sendGetLastSeen(const QString &jid)
     ProtocolTreeNode queryNode("query");
     iqNode.addChild(queryNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(contactLastSeen));
+    int bytes = sendRequest(iqNode, ReplyLastSeen);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -182,7 +252,7 @@ void WAConnectionPrivate::sendGetStatuses(const QStringList &jids)
     iqNode.setAttributes(attrs);
     iqNode.addChild(statusNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(contactsStatuses));
+    int bytes = sendRequest(iqNode, ReplyStatuses);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -202,7 +272,7 @@ void WAConnectionPrivate::sendGetPicture(const QString &jid)
     pictureNode.setAttributes(attrs);
     iqNode.addChild(pictureNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(contactPicture));
+    int bytes = sendRequest(iqNode, ReplyPicture);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -230,7 +300,7 @@ void WAConnectionPrivate::sendGetPictureIds(const QStringList &jids)
     attrs.clear();
     iqNode.addChild(listNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(contactsPicrureIds));
+    int bytes = sendRequest(iqNode, ReplyPictureIds);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -267,7 +337,7 @@ void WAConnectionPrivate::sendGetPrivacyList()
 
     iqNode.addChild(queryNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(privacyList));
+    int bytes = sendRequest(iqNode, ReplyPrivacyList);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -333,7 +403,7 @@ void WAConnectionPrivate::sendGetPushConfig()
     ProtocolTreeNode configNode("config");
     iqNode.addChild(configNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(pushConfig));
+    int bytes = sendRequest(iqNode, ReplyPushConfig);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -353,7 +423,7 @@ void WAConnectionPrivate::sendSetPresence(bool available, const QString &pushnam
 
 void WAConnectionPrivate::sendText(const QString &jid, const QString &text, const QString &msgId)
 {
-    if (q_ptr->m_connectionStatus != WAConnection::LoggedIn) {
+    if (q_ptr->getConnectionStatus() != WAConnection::LoggedIn) {
         return;
     }
 
@@ -384,7 +454,7 @@ void WAConnectionPrivate::sendText(const QString &jid, const QString &text, cons
             return;
         }
     }
-    int bytes = sendRequest(message, WAREPLY(messageSent));
+    int bytes = sendRequest(message, ReplyMessageSent);
 
     Q_EMIT q_ptr->textMessageSent(jid, message.getAttributeValue("id"), QString::number(QDateTime::currentDateTime().toTime_t() + serverTimeCorrection), text);
 }
@@ -505,7 +575,7 @@ void WAConnectionPrivate::sendSync(const QStringList &syncContacts, const QStrin
     iqNode.setAttributes(attrs);
     iqNode.addChild(syncNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(syncResponse));
+    int bytes = sendRequest(iqNode, ReplySync);
 }
 
 void WAConnectionPrivate::sendGetFeatures(const QStringList &jids)
@@ -531,7 +601,7 @@ void WAConnectionPrivate::sendGetFeatures(const QStringList &jids)
     featureNode.addChild(listNode);
     iqNode.addChild(featureNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(featureResponse));
+    int bytes = sendRequest(iqNode, ReplyFeatures);
 }
 
 void WAConnectionPrivate::sendGetGroups(const QString &type)
@@ -548,7 +618,7 @@ void WAConnectionPrivate::sendGetGroups(const QString &type)
     ProtocolTreeNode childNode(type);
     iqNode.addChild(childNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(groupsResponse));
+    int bytes = sendRequest(iqNode, ReplyGroups);
 }
 
 void WAConnectionPrivate::sendGetBroadcasts()
@@ -564,7 +634,7 @@ void WAConnectionPrivate::sendGetBroadcasts()
     ProtocolTreeNode listsNode("lists");
     iqNode.addChild(listsNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(broadcastsResponse));
+    int bytes = sendRequest(iqNode, ReplyBroadcasts);
 }
 
 void WAConnectionPrivate::sendSetStatusMessage(const QString &message)
@@ -601,30 +671,170 @@ void WAConnectionPrivate::sendTyping(const QString &jid, bool typing)
 
 void WAConnectionPrivate::getEncryptionStatus(const QString &jid)
 {
-    if (q_ptr->m_connectionStatus == WAConnection::LoggedIn) {
+    if (q_ptr->getConnectionStatus() == WAConnection::LoggedIn) {
         qulonglong recepientId = getRecepient(jid);
         bool encrypted = axolotlStore->containsSession(recepientId, 1) || cipherHash.contains(recepientId);
         Q_EMIT q_ptr->encryptionStatus(jid, encrypted);
     }
 }
 
+QVariantMap WAConnectionPrivate::getStatistics()
+{
+    QVariantMap stats;
+    if (!in)
+        return stats;
+
+    const ReceiveBuffer &receiveBuffer = in->getReceiveBuffer();
+    stats["receiveBufferLimit"] = receiveBuffer.getLimit();
+    stats["receiveBufferCapacity"] = receiveBuffer.getCapacity();
+    stats["receiveBufferPeak"] = receiveBuffer.getPeakSize();
+    stats["receiveBufferReallocations"] = receiveBuffer.getReallocations();
+    stats["payloadBytesStreamed"] = in->getBytesStreamed();
+    stats["payloadBytesBuffered"] = in->getBytesBuffered();
+    stats["filteredStanzas"] = in->getFilteredStanzas();
+    stats["pendingReplies"] = replies->size();
+    stats["receiptsBatched"] = receipts->getReceiptsQueued();
+    stats["receiptFrames"] = receipts->getReceiptFrames();
+    stats["acksBatched"] = receipts->getAcksQueued();
+
+    QVariantMap replyStats;
+    for (int type = 0; type < ReplyTypeCount; type++) {
+        QVariantMap typeStats;
+        typeStats["replies"] = replies->getReplies(type);
+        typeStats["expired"] = replies->getExpired(type);
+        typeStats["averageLatency"] = replies->getAverageLatency(type);
+        typeStats["maxLatency"] = replies->getMaxLatency(type);
+        replyStats[replyHandlers[type].name] = typeStats;
+    }
+    stats["replies"] = replyStats;
+    stats["writeCoalescing"] = out->isCoalescing();
+    stats["framesWritten"] = out->getFramesWritten();
+    stats["socketWrites"] = out->getFlushes();
+    stats["bytesWrittenDirect"] = out->getBytesWrittenDirect();
+    stats["framesPerFlush"] = out->getFlushes() > 0
+            ? (double) out->getFramesWritten() / out->getFlushes() : 0.0;
+
+    return stats;
+}
+
+void WAConnectionPrivate::setPayloadSink(PayloadSink *sink, int threshold)
+{
+    m_payloadSink = sink;
+    m_payloadThreshold = threshold;
+    if (in)
+        in->setPayloadSink(sink, threshold);
+}
+
+bool WAConnectionPrivate::addStanzaFilter(const QString &tag, const QString &attribute, const QString &value)
+{
+    int tagToken = WATokenDictionary::tokenId(tag);
+    int attributeToken = attribute.isEmpty() ? -1 : WATokenDictionary::tokenId(attribute);
+    int valueToken = value.isEmpty() ? -1 : WATokenDictionary::tokenId(value);
+
+    if (tagToken < 0 || (!attribute.isEmpty() && attributeToken < 0)
+            || (!value.isEmpty() && valueToken < 0)) {
+        qDebug() << "Can't filter on non dictionary strings" << tag << attribute << value;
+        return false;
+    }
+
+    StanzaFilterTokens filter;
+    filter.tag = tagToken;
+    filter.attribute = attributeToken;
+    filter.value = valueToken;
+    m_stanzaFilters.append(filter);
+
+    if (in)
+        in->addStanzaFilter(tagToken, attributeToken, valueToken);
+    return true;
+}
+
+void WAConnectionPrivate::clearStanzaFilters()
+{
+    m_stanzaFilters.clear();
+    if (in)
+        in->clearStanzaFilters();
+}
+
+void WAConnectionPrivate::setWriteCoalescing(bool enabled)
+{
+    m_writeCoalescing = enabled;
+    if (out)
+        out->setCoalescing(enabled);
+}
+
+void WAConnectionPrivate::setReceiptBatching(int window, int maxLatency)
+{
+    m_receiptWindow = window;
+    m_receiptMaxLatency = maxLatency;
+    if (receipts)
+        receipts->setWindow(window, maxLatency);
+}
+
+void WAConnectionPrivate::setStoreConnectionName(const QString &name)
+{
+    if (axolotlStore)
+        qWarning() << "The store connection name must be set before init()";
+    else
+        m_storeConnection = name;
+}
+
+void WAConnectionPrivate::copySettings(const WAConnectionPrivate *other)
+{
+    m_storeConnection = other->m_storeConnection;
+    m_payloadSink = other->m_payloadSink;
+    m_payloadThreshold = other->m_payloadThreshold;
+    m_stanzaFilters = other->m_stanzaFilters;
+    m_writeCoalescing = other->m_writeCoalescing;
+    m_receiptWindow = other->m_receiptWindow;
+    m_receiptMaxLatency = other->m_receiptMaxLatency;
+    stanzaHandlers = other->stanzaHandlers;
+}
+
 int WAConnectionPrivate::sendRequest(const ProtocolTreeNode &node)
 {
-    if (socket->isOpen()) {
+    if (socket && socket->isOpen()) {
         return out->write(node, false);
     }
     return 0;
 }
 
-int WAConnectionPrivate::sendRequest(const ProtocolTreeNode &node, const char *member)
+int WAConnectionPrivate::sendRequest(const ProtocolTreeNode &node, ReplyType reply)
 {
-    if (socket->isOpen()) {
-        m_bindStore[node.getAttributeValue("id")] = member;
+    if (socket && socket->isOpen()) {
+        replies->insert(node.getAttributeValue("id"), reply, replyHandlers[reply].timeout);
         return sendRequest(node);
     }
     return 0;
 }
 
+void WAConnectionPrivate::replyExpired(const QString &id, int type)
+{
+    qDebug() << "No reply to" << replyHandlers[type].name << id;
+    if (replyHandlers[type].expired)
+        (this->*replyHandlers[type].expired)(id);
+}
+
+void WAConnectionPrivate::pingExpired(const QString &id)
+{
+    Q_UNUSED(id);
+
+    // Dead connection, go through the usual reconnection
+    socketLastError = QAbstractSocket::RemoteHostClosedError;
+    socket->abort();
+}
+
+// The store is published before the signal is emitted, so a receiver
+// calling getConnectionStatus() sees at least this status
+void WAConnectionPrivate::setConnectionStatus(int status)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+    q_ptr->m_connectionStatus.storeRelease(status);
+#else
+    q_ptr->m_connectionStatus.fetchAndStoreRelease(status);
+#endif
+    Q_EMIT q_ptr->connectionStatusChanged(status);
+}
+
 void WAConnectionPrivate::tryLogin()
 {
     int outBytes, inBytes;
@@ -645,14 +855,13 @@ void WAConnectionPrivate::loginInternal()
             this, SLOT(socketError(QAbstractSocket::SocketError)));
     connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
 
-    q_ptr->m_connectionStatus = WAConnection::Connecting;
-    Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+    setConnectionStatus(WAConnection::Connecting);
 
     QTime midnight(0,0,0);
     qsrand(midnight.secsTo(QTime::currentTime()));
     QString server = m_servers.at(qrand() % m_servers.size());
 
-    qDebug() << "Connecting to" << server + ":443";
+    WA_LOG(WALogConnection, WALogInfo) << "Connecting to" << server + ":443";
     socket->connectToHost(server, 443);
 }
 
@@ -683,7 +892,7 @@ int WAConnectionPrivate::sendAuth()
     }
     attrs.insert("mechanism", "WAUTH-2");
     attrs.insert("user", m_username);
-    qDebug() << "Sending" << "WAUTH-2" << "for" << m_username;
+    WA_LOG(WALogConnection, WALogInfo) << "Sending" << "WAUTH-2" << "for" << m_username;
 
     ProtocolTreeNode node("auth");
     node.setAttributes(attrs);
@@ -717,9 +926,9 @@ QByteArray WAConnectionPrivate::getAuthBlob(const QByteArray &nonce)
     if (!m_mcc.isEmpty() && !m_mnc.isEmpty()) {
         list.append(QString(" MccMnc/%1%2").arg(m_mcc).arg(m_mnc));
     }*/
-    qDebug() << list.mid(4 + m_username.size() + nonce.size());
+    WA_LOG(WALogConnection, WALogDebug) << list.mid(4 + m_username.size() + nonce.size());
 
-    outputKey->encodeMessage(list, 0, 4, list.length()-4);
+    outputKey->encodeMessage(list.data() + 4, list.length() - 4, list.data());
 
     return list;
 }
@@ -764,16 +973,14 @@ void WAConnectionPrivate::parseSuccessNode(const ProtocolTreeNode &node)
     sendGetPushConfig();
 
     if (m_passive) {
-        q_ptr->m_connectionStatus = WAConnection::Initiaization;
-        Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+        setConnectionStatus(WAConnection::Initiaization);
     }
     else {
         sendPing();
 
         //lastActivity = QDateTime::currentDateTime().toTime_t();
 
-        q_ptr->m_connectionStatus = WAConnection::LoggedIn;
-        Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+        setConnectionStatus(WAConnection::LoggedIn);
     }
 }
 
@@ -948,24 +1155,24 @@ void WAConnectionPrivate::parseReceiptList(const ProtocolTreeNode &node)
     }
 }
 
-void WAConnectionPrivate::parsePresence(const ProtocolTreeNode &node)
+void WAConnectionPrivate::parsePresence(const ProtocolTreeNodeView &node)
 {
-    QString jid = node.getAttributeValue("from");
-    if (node.getAttributes().contains("type")) {
-        Q_EMIT q_ptr->contactUnavailable(jid, node.getAttributeValue("last"));
+    QString jid = node.getAttributeValue(WATokenDictionary::TokenFrom);
+    if (node.hasAttribute(WATokenDictionary::TokenType)) {
+        Q_EMIT q_ptr->contactUnavailable(jid, node.getAttributeValue(WATokenDictionary::TokenLast));
     }
     else {
         Q_EMIT q_ptr->contactAvailable(jid);
     }
 }
 
-void WAConnectionPrivate::parseChatstate(const ProtocolTreeNode &node)
+void WAConnectionPrivate::parseChatstate(const ProtocolTreeNodeView &node)
 {
-    QString jid = node.getAttributeValue("from");
-    if (node.getChildren().contains("paused")) {
+    QString jid = node.getAttributeValue(WATokenDictionary::TokenFrom);
+    if (node.hasChild(WATokenDictionary::TokenPaused)) {
         Q_EMIT q_ptr->contactTypingPaused(jid);
     }
-    else if (node.getChildren().contains("composing")) {
+    else if (node.hasChild(WATokenDictionary::TokenComposing)) {
         Q_EMIT q_ptr->contactTypingStarted(jid);
     }
 }
@@ -1019,6 +1226,9 @@ void WAConnectionPrivate::sendClientConfig()
 
 void WAConnectionPrivate::sendMessageReceived(const QString &jid, const QString &msdId, const QString &type, const QString &participant)
 {
+    if (receipts->addReceipt(jid, msdId, type, participant))
+        return;
+
     ProtocolTreeNode receiptNode("receipt");
     AttributeList attrs;
     attrs.insert("to", jid);
@@ -1074,6 +1284,9 @@ void WAConnectionPrivate::sendReceiptAck(const ProtocolTreeNode &node)
     attrs.insert("to", node.getAttributeValue("from"));
     ProtocolTreeNode ackNode("ack", attrs);
 
+    if (receipts->addAck(ackNode))
+        return;
+
     int bytes = sendRequest(ackNode);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
@@ -1130,6 +1343,9 @@ void WAConnectionPrivate::sendNotificationReceived(const ProtocolTreeNode &node)
         ackNode.addChild(sync);
     }
 
+    if (receipts->addAck(ackNode))
+        return;
+
     int bytes = sendRequest(ackNode);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
@@ -1160,7 +1376,7 @@ void WAConnectionPrivate::sendPassive(const QString &mode)
     ProtocolTreeNode modeNode(mode);
     iqNode.addChild(modeNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(passiveResponse));
+    int bytes = sendRequest(iqNode, ReplyPassive);
     //counters->increaseCounter(DataCounters::ProtocolBytes, 0, bytes);
 }
 
@@ -1434,7 +1650,7 @@ void WAConnectionPrivate::sendEncrypt(bool fresh)
     iqNode.addChild(typeNode);
     iqNode.addChild(skeyNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(encryptionReply));
+    int bytes = sendRequest(iqNode, ReplyEncrypt);
 }
 
 void WAConnectionPrivate::sendGetEncryptKeys(const QStringList &jids)
@@ -1459,7 +1675,7 @@ void WAConnectionPrivate::sendGetEncryptKeys(const QStringList &jids)
 
     iqNode.addChild(keyNode);
 
-    int bytes = sendRequest(iqNode, WAREPLY(getKeysReponse));
+    int bytes = sendRequest(iqNode, ReplyGetKeys);
 }
 
 qulonglong WAConnectionPrivate::getRecepient(const QString &jid)
@@ -1469,181 +1685,233 @@ qulonglong WAConnectionPrivate::getRecepient(const QString &jid)
 
 bool WAConnectionPrivate::read()
 {
-    ProtocolTreeNode node;
+    ProtocolTreeNodeView view;
 
-    if (!m_isReading) {
-        m_isReading = true;
-    }
-    else {
-        return true;
-    }
-
-    if (in->nextTree(node))
+    if (in->nextTree(view))
     {
         bool handled = false;
 
-        QString id = node.getAttributeValue("id");
-        if (m_bindStore.contains(id)) {
-            QMetaObject::invokeMethod(this, m_bindStore.take(id), Q_ARG(ProtocolTreeNode, node));
+        QString id = view.getAttributeValue(WATokenDictionary::TokenId);
+        int reply = replies->take(id);
+        if (reply >= 0) {
+            ProtocolTreeNode node = view.toProtocolTreeNode();
+            (this->*replyHandlers[reply].handler)(node);
             handled = true;
         }
         else {
-            QString tag = node.getTag();
-
-            if (tag == "stream:start")
-            {
-                handled = true;
-            }
-            else if (tag == "stream:close")
-            {
-                handled = true;
-            }
-            else if (tag == "stream:features")
-            {
-                handled = true;
-            }
-            else if (tag == "stream:error")
-            {
-                qDebug() << "STREAM_ERROR!";
-                ProtocolTreeNodeListIterator i(node.getChildren());
-                while (i.hasNext())
-                {
-                    ProtocolTreeNode child = i.next().value();
-                    qDebug() << child.getTag() << child.getDataString();
-                }
-                Q_EMIT q_ptr->streamError();
-                handled = true;
-            }
-            else if (tag == "challenge")
-            {
-                m_nextChallenge = node.getData();
-                sendResponse(m_nextChallenge);
-                handled = true;
-            }
-            else if (tag == "success")
-            {
-                parseSuccessNode(node);
-                handled = true;
-            }
-            else if (tag == "failure")
-            {
-                Q_EMIT q_ptr->authFailed();
-                m_authFailed = true;
-                handled = true;
-            }
-            else if (tag == "message")
-            {
-                if (parseMessage(node)) {
-                    sendMessageReceived(node.getAttributeValue("from"), node.getAttributeValue("id"), QString(), node.getAttributeValue("participant"));
-                }
-                handled = true;
-            }
-            else if (tag == "iq")
-            {
-                QString xmlns = node.getAttributeValue("xmlns");
-                QString id = node.getAttributeValue("id");
-                if (xmlns == "urn:xmpp:ping") {
-                    sendResult(id);
-                    handled = true;
-                }
-            }
-            else if (tag == "notification")
-            {
-                sendNotificationReceived(node);
-                QString type = node.getAttributeValue("type");
-                if (type == "contacts") {
-                    parseContactsNotification(node);
-                }
-                else if (type == "picture") {
-                    parsePictureNotification(node);
-                }
-                else if (type == "w:gp2") {
-                    parseGroupNotification(node);
-                }
-                else if (type == "status") {
-                    parseStatusNotification(node);
-                }
-                else if (type == "encrypt") {
-                    parseEncryptNotification(node);
-                }
-                handled = true;
-            }
-            else if (tag == "receipt")
-            {
-                parseReceipt(node);
-                sendReceiptAck(node);
-                handled = true;
-            }
-            else if (tag == "ib")
-            {
-                ProtocolTreeNodeListIterator i(node.getChildren());
-                while (i.hasNext()) {
-                    ProtocolTreeNode child = i.next().value();
-                    if (child.getTag() == "dirty") {
-                        sendCleanDirty(QStringList() << child.getAttributeValue("type"));
-                        handled = true;
-                    }
-                    else if (child.getTag() == "offline") {
-                        Q_EMIT q_ptr->notifyOfflineMessages(child.getAttributeValue("count").toInt());
-                        handled = true;
-                    }
-                }
-            }
-            else if (tag == "ack")
-            {
-                handled = true;
-            }
-            else if (tag == "presence")
-            {
-                parsePresence(node);
-                handled = true;
-            }
-            else if (tag == "chatstate")
-            {
-                parseChatstate(node);
-                handled = true;
-            }
-            else if (tag == "call") {
-                parseCall(node);
-                handled = true;
-            }
+            handled = dispatchStanza(view, id);
         }
-        if (!handled) {
-            qDebug() << "TODO: Unhandled node!";
+
+        if (!handled && !dispatchToHandlers(view)) {
+            qDebug() << "TODO: Unhandled node!" << view.getTag();
         }
-        if (node.getAttributes().contains("notify")) {
-            QString notify = node.getAttributeValue("notify");
-            QString user = node.getAttributes().contains("participant") ? node.getAttributeValue("participant") : node.getAttributeValue("from");
+        if (view.hasAttribute(WATokenDictionary::TokenNotify)) {
+            QString notify = view.getAttributeValue(WATokenDictionary::TokenNotify);
+            QString user = view.hasAttribute(WATokenDictionary::TokenParticipant) ? view.getAttributeValue(WATokenDictionary::TokenParticipant) : view.getAttributeValue(WATokenDictionary::TokenFrom);
             Q_EMIT q_ptr->notifyPushname(user, notify);
         }
 
-        m_isReading = false;
+        return true;
+    }
 
+    return false;
+}
+
+// Built-in handling, switching on the tag token
+bool WAConnectionPrivate::dispatchStanza(const ProtocolTreeNodeView &view, const QString &id)
+{
+    int tag = view.getTagToken();
+
+    // Frequent stanzas that only need a couple of attributes are handled
+    // straight from the view, without building the tree
+    switch (tag) {
+    case WATokenDictionary::TokenAck:
+    case WATokenDictionary::TokenStreamStart:
+    case WATokenDictionary::TokenStreamClose:
+    case WATokenDictionary::TokenStreamFeatures:
+        return true;
+    case WATokenDictionary::TokenPresence:
+        parsePresence(view);
+        return true;
+    case WATokenDictionary::TokenChatstate:
+        parseChatstate(view);
+        return true;
+    case WATokenDictionary::TokenIq:
+        if (view.attributeEquals(WATokenDictionary::TokenXmlns, WATokenDictionary::TokenUrnXmppPing)) {
+            sendResult(id);
+            return true;
+        }
+        return false;
+    case WATokenDictionary::TokenIb:
+        return parseIb(view);
+    case WATokenDictionary::TokenStreamError:
+    case WATokenDictionary::TokenChallenge:
+    case WATokenDictionary::TokenSuccess:
+    case WATokenDictionary::TokenFailure:
+    case WATokenDictionary::TokenMessage:
+    case WATokenDictionary::TokenNotification:
+    case WATokenDictionary::TokenReceipt:
+        break;
+    default:
+        // "call" isn't in the token dictionary
+        if (tag < 0 && view.hasTag("call")) {
+            parseCall(view.toProtocolTreeNode());
+            return true;
+        }
+        return false;
+    }
+
+    ProtocolTreeNode node = view.toProtocolTreeNode();
+
+    switch (tag) {
+    case WATokenDictionary::TokenStreamError: {
+        WA_LOG(WALogConnection, WALogError) << "STREAM_ERROR!";
+        ProtocolTreeNodeListIterator i(node.getChildren());
+        while (i.hasNext())
+        {
+            ProtocolTreeNode child = i.next().value();
+            WA_LOG(WALogConnection, WALogError) << child.getTag() << child.getDataString();
+        }
+        Q_EMIT q_ptr->streamError();
+        return true;
+    }
+    case WATokenDictionary::TokenChallenge:
+        m_nextChallenge = node.getData();
+        sendResponse(m_nextChallenge);
+        return true;
+    case WATokenDictionary::TokenSuccess:
+        parseSuccessNode(node);
+        return true;
+    case WATokenDictionary::TokenFailure:
+        Q_EMIT q_ptr->authFailed();
+        m_authFailed = true;
         return true;
+    case WATokenDictionary::TokenMessage:
+        if (parseMessage(node)) {
+            sendMessageReceived(node.getAttributeValue("from"), node.getAttributeValue("id"), QString(), node.getAttributeValue("participant"));
+        }
+        return true;
+    case WATokenDictionary::TokenNotification:
+        sendNotificationReceived(node);
+        switch (view.getAttributeToken(WATokenDictionary::TokenType)) {
+        case WATokenDictionary::TokenContacts:
+            parseContactsNotification(node);
+            return true;
+        case WATokenDictionary::TokenPicture:
+            parsePictureNotification(node);
+            return true;
+        case WATokenDictionary::TokenWGp2:
+            parseGroupNotification(node);
+            return true;
+        case WATokenDictionary::TokenStatus:
+            parseStatusNotification(node);
+            return true;
+        case WATokenDictionary::TokenEncrypt:
+            parseEncryptNotification(node);
+            return true;
+        }
+        // Acknowledged, but left to the application handlers
+        return false;
+    case WATokenDictionary::TokenReceipt:
+        parseReceipt(node);
+        sendReceiptAck(node);
+        return true;
+    }
+
+    return false;
+}
+
+bool WAConnectionPrivate::parseIb(const ProtocolTreeNodeView &view)
+{
+    bool handled = false;
+
+    ProtocolTreeNodeView child = view.firstChild();
+    while (child.isValid()) {
+        if (child.hasTag(WATokenDictionary::TokenDirty)) {
+            sendCleanDirty(QStringList() << child.getAttributeValue(WATokenDictionary::TokenType));
+            handled = true;
+        }
+        else if (child.hasTag(WATokenDictionary::TokenOffline)) {
+            Q_EMIT q_ptr->notifyOfflineMessages(child.getAttributeValue(WATokenDictionary::TokenCount).toInt());
+            handled = true;
+        }
+        child = child.nextSibling();
+    }
+
+    return handled;
+}
+
+// Application handlers, in registration order
+bool WAConnectionPrivate::dispatchToHandlers(const ProtocolTreeNodeView &view)
+{
+    if (stanzaHandlers.isEmpty())
+        return false;
+
+    // A handler may remove itself, iterate over a (shared) copy
+    QList<StanzaHandlerEntry> handlers = stanzaHandlers;
+
+    ProtocolTreeNode node;
+    bool materialized = false;
+
+    foreach (const StanzaHandlerEntry &entry, handlers) {
+        if (entry.tag >= 0 ? !view.hasTag(entry.tag) : !view.hasTag(entry.tagName.constData()))
+            continue;
+        if (!entry.typeName.isEmpty()) {
+            if (entry.type >= 0 ? !view.attributeEquals(WATokenDictionary::TokenType, entry.type)
+                    : view.getAttributeValue(WATokenDictionary::TokenType) != entry.typeName)
+                continue;
+        }
+
+        if (!materialized) {
+            view.materialize(node);
+            materialized = true;
+        }
+        if (entry.handler->handleStanza(node))
+            return true;
     }
 
     return false;
 }
 
+void WAConnectionPrivate::addStanzaHandler(StanzaHandler *handler, const QString &tag, const QString &type)
+{
+    StanzaHandlerEntry entry;
+    entry.tag = WATokenDictionary::tokenId(tag);
+    entry.type = type.isEmpty() ? -1 : WATokenDictionary::tokenId(type);
+    entry.tagName = tag.toUtf8();
+    entry.typeName = type;
+    entry.handler = handler;
+    stanzaHandlers.append(entry);
+}
+
+void WAConnectionPrivate::removeStanzaHandler(StanzaHandler *handler)
+{
+    for (int i = stanzaHandlers.size() - 1; i >= 0; i--) {
+        if (stanzaHandlers.at(i).handler == handler)
+            stanzaHandlers.removeAt(i);
+    }
+}
+
 void WAConnectionPrivate::socketConnected()
 {
     socketLastError = QAbstractSocket::UnknownSocketError;
 
-    qDebug() << "connected";
+    WA_LOG(WALogConnection, WALogInfo) << "connected";
     socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
 
-    q_ptr->m_connectionStatus = WAConnection::Connected;
-    Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+    setConnectionStatus(WAConnection::Connected);
 
     tryLogin();
 }
 
 void WAConnectionPrivate::socketDisconnected()
 {
-    qDebug() << "disconnected" << socketLastError;
+    WA_LOG(WALogConnection, WALogInfo) << "disconnected" << socketLastError;
     QObject::disconnect(socket, 0, 0, 0);
     out->reset();
     in->reset();
+    replies->clear();
+    receipts->clear();
     iqid = 0;
     mseq = 0;
     cipherHash.clear();
@@ -1652,16 +1920,14 @@ void WAConnectionPrivate::socketDisconnected()
         m_nextChallenge.clear();
         int maxRetry = 10;
         if (!m_authFailed && retry < maxRetry) {
-            q_ptr->m_connectionStatus = WAConnection::Connecting;
-            Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+            setConnectionStatus(WAConnection::Connecting);
 
             retry++;
-            qDebug() << QString("Retry login in %1 seconds... [%2/%3]").arg(retry).arg(retry).arg(maxRetry);
+            WA_LOG(WALogConnection, WALogInfo) << QString("Retry login in %1 seconds... [%2/%3]").arg(retry).arg(retry).arg(maxRetry);
             QTimer::singleShot(retry * 1000, this, SLOT(loginInternal()));
         }
         else {
-            q_ptr->m_connectionStatus = WAConnection::Disconnected;
-            Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+            setConnectionStatus(WAConnection::Disconnected);
         }
     }
     else if (m_passiveReconnect) {
@@ -1669,19 +1935,17 @@ void WAConnectionPrivate::socketDisconnected()
         QTimer::singleShot(1000, this, SLOT(loginInternal()));
     }
     else {
-        q_ptr->m_connectionStatus = WAConnection::Disconnected;
-        Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+        setConnectionStatus(WAConnection::Disconnected);
     }
 }
 
 void WAConnectionPrivate::socketError(QAbstractSocket::SocketError error)
 {
-    qDebug() << "error:" << error << "isOpen" << socket->isOpen();
+    WA_LOG(WALogConnection, WALogWarning) << "error:" << error << "isOpen" << socket->isOpen();
     socketLastError = error;
 
     if (error == QTcpSocket::NetworkError) {
-        q_ptr->m_connectionStatus = WAConnection::Disconnected;
-        Q_EMIT q_ptr->connectionStatusChanged(q_ptr->m_connectionStatus);
+        setConnectionStatus(WAConnection::Disconnected);
     }
 }
 
@@ -2100,13 +2364,23 @@ void WAConnectionPrivate::pushConfig(const ProtocolTreeNode &node)
 
 WAConnection::WAConnection(QObject *parent) :
     QObject(parent),
-    d_ptr(new WAConnectionPrivate(this))
+    d_ptr(new WAConnectionPrivate(this)),
+    m_connectionStatus(Disconnected),
+    m_networkThread(NULL),
+    m_ownsNetworkThread(false),
+    m_initialized(false)
 {
     qRegisterMetaType<AttributeList>("AttributeList");
 }
 
 WAConnection::~WAConnection()
 {
+    // The private object and its socket die in their own thread
+    QMetaObject::invokeMethod(d_ptr, "dispose", blockingConnection());
+    if (m_ownsNetworkThread) {
+        m_networkThread->quit();
+        m_networkThread->wait();
+    }
 }
 
 WAConnection *WAConnection::GetInstance(QObject *parent)
@@ -2118,137 +2392,277 @@ WAConnection *WAConnection::GetInstance(QObject *parent)
     return lsSingleton;
 }
 
+void WAConnection::setNetworkThreadEnabled(bool enabled)
+{
+    if (enabled == m_ownsNetworkThread)
+        return;
+
+    if (enabled) {
+        if (m_initialized) {
+            qWarning() << "The network thread must be set up before init()";
+            return;
+        }
+        QThread *thread = new QThread(this);
+        thread->start();
+        setNetworkThread(thread);
+        m_ownsNetworkThread = true;
+    }
+    else {
+        setNetworkThread(NULL);
+    }
+}
+
+bool WAConnection::isNetworkThreadEnabled() const
+{
+    return m_networkThread != NULL;
+}
+
+void WAConnection::setNetworkThread(QThread *thread)
+{
+    if (thread == m_networkThread)
+        return;
+    if (m_initialized) {
+        qWarning() << "The network thread must be set up before init()";
+        return;
+    }
+
+    if (m_networkThread) {
+        // Nothing but settings lives in the private object before init(),
+        // start over with a fresh one in this thread. The setters all wait
+        // for the network thread, so the old object is up to date.
+        WAConnectionPrivate *old = d_ptr;
+        d_ptr = new WAConnectionPrivate(this);
+        d_ptr->copySettings(old);
+        QMetaObject::invokeMethod(old, "dispose",
+                                  old->thread() == QThread::currentThread()
+                                  ? Qt::DirectConnection : Qt::BlockingQueuedConnection);
+
+        if (m_ownsNetworkThread) {
+            m_networkThread->quit();
+            m_networkThread->wait();
+            delete m_networkThread;
+        }
+    }
+
+    m_networkThread = thread;
+    m_ownsNetworkThread = false;
+
+    if (m_networkThread) {
+        // A QObject with a parent can't change threads
+        d_ptr->setParent(0);
+        d_ptr->moveToThread(m_networkThread);
+    }
+}
+
+QThread *WAConnection::getNetworkThread() const
+{
+    return m_networkThread;
+}
+
+void WAConnection::setStoreConnectionName(const QString &name)
+{
+    QMetaObject::invokeMethod(d_ptr, "setStoreConnectionName", blockingConnection(),
+                              Q_ARG(QString, name));
+}
+
+// Calls returning a value wait for the network thread, the rest are queued.
+// Without a network thread both end up as direct calls.
+Qt::ConnectionType WAConnection::blockingConnection() const
+{
+    return (d_ptr->thread() == QThread::currentThread()) ? Qt::DirectConnection
+                                                         : Qt::BlockingQueuedConnection;
+}
+
 void WAConnection::init()
 {
-    d_ptr->init();
+    m_initialized = true;
+    QMetaObject::invokeMethod(d_ptr, "init", blockingConnection());
 }
 
 int WAConnection::getConnectionStatus()
 {
-    return m_connectionStatus;
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+    return m_connectionStatus.loadAcquire();
+#else
+    return m_connectionStatus.fetchAndAddAcquire(0);
+#endif
+}
+
+QVariantMap WAConnection::getStatistics()
+{
+    QVariantMap stats;
+    QMetaObject::invokeMethod(d_ptr, "getStatistics", blockingConnection(),
+                              Q_RETURN_ARG(QVariantMap, stats));
+    return stats;
+}
+
+void WAConnection::setPayloadSink(PayloadSink *sink, int threshold)
+{
+    QMetaObject::invokeMethod(d_ptr, "setPayloadSink", blockingConnection(),
+                              Q_ARG(PayloadSink*, sink), Q_ARG(int, threshold));
+}
+
+bool WAConnection::addStanzaFilter(const QString &tag, const QString &attribute, const QString &value)
+{
+    bool result = false;
+    QMetaObject::invokeMethod(d_ptr, "addStanzaFilter", blockingConnection(),
+                              Q_RETURN_ARG(bool, result),
+                              Q_ARG(QString, tag), Q_ARG(QString, attribute), Q_ARG(QString, value));
+    return result;
+}
+
+void WAConnection::clearStanzaFilters()
+{
+    QMetaObject::invokeMethod(d_ptr, "clearStanzaFilters", blockingConnection());
+}
+
+void WAConnection::addStanzaHandler(StanzaHandler *handler, const QString &tag, const QString &type)
+{
+    QMetaObject::invokeMethod(d_ptr, "addStanzaHandler", blockingConnection(),
+                              Q_ARG(StanzaHandler*, handler), Q_ARG(QString, tag), Q_ARG(QString, type));
+}
+
+void WAConnection::removeStanzaHandler(StanzaHandler *handler)
+{
+    QMetaObject::invokeMethod(d_ptr, "removeStanzaHandler", blockingConnection(),
+                              Q_ARG(StanzaHandler*, handler));
+}
+
+void WAConnection::setReceiptBatching(int window, int maxLatency)
+{
+    QMetaObject::invokeMethod(d_ptr, "setReceiptBatching", blockingConnection(),
+                              Q_ARG(int, window), Q_ARG(int, maxLatency));
+}
+
+void WAConnection::setWriteCoalescing(bool enabled)
+{
+    QMetaObject::invokeMethod(d_ptr, "setWriteCoalescing", blockingConnection(),
+                              Q_ARG(bool, enabled));
 }
 
 void WAConnection::login(const QVariantMap &loginData)
 {
-    d_ptr->login(loginData);
+    QMetaObject::invokeMethod(d_ptr, "login", Q_ARG(QVariantMap, loginData));
 }
 
 void WAConnection::logout()
 {
-    d_ptr->logout();
+    QMetaObject::invokeMethod(d_ptr, "logout");
 }
 
 void WAConnection::reconnect()
 {
-    d_ptr->reconnect();
+    QMetaObject::invokeMethod(d_ptr, "reconnect");
 }
 
 void WAConnection::sendGetProperties()
 {
-    d_ptr->sendGetProperties();
+    QMetaObject::invokeMethod(d_ptr, "sendGetProperties");
 }
 
 void WAConnection::sendPing()
 {
-    d_ptr->sendPing();
+    QMetaObject::invokeMethod(d_ptr, "sendPing");
 }
 
 void WAConnection::sendAvailable(const QString &pushname)
 {
-    d_ptr->sendSetPresence(true, pushname);
+    QMetaObject::invokeMethod(d_ptr, "sendSetPresence",
+                              Q_ARG(bool, true), Q_ARG(QString, pushname));
 }
 
 void WAConnection::sendUnavailable(const QString &pushname)
 {
-    d_ptr->sendSetPresence(false, pushname);
+    QMetaObject::invokeMethod(d_ptr, "sendSetPresence",
+                              Q_ARG(bool, false), Q_ARG(QString, pushname));
 }
 
 void WAConnection::getEncryptionStatus(const QString &jid)
 {
-    d_ptr->getEncryptionStatus(jid);
+    QMetaObject::invokeMethod(d_ptr, "getEncryptionStatus", Q_ARG(QString, jid));
 }
 
 void WAConnection::sendTyping(const QString &jid, bool typing)
 {
-    d_ptr->sendTyping(jid, typing);
+    QMetaObject::invokeMethod(d_ptr, "sendTyping", Q_ARG(QString, jid), Q_ARG(bool, typing));
 }
 
 void WAConnection::sendSetStatusMessage(const QString &message)
 {
-    d_ptr->sendSetStatusMessage(message);
+    QMetaObject::invokeMethod(d_ptr, "sendSetStatusMessage", Q_ARG(QString, message));
 }
 
 void WAConnection::sendRetryMessage(const QString &jid, const QString &msgId, const QString &data)
 {
-    d_ptr->sendRetryMessage(jid, msgId, data);
+    QMetaObject::invokeMethod(d_ptr, "sendRetryMessage",
+                              Q_ARG(QString, jid), Q_ARG(QString, msgId), Q_ARG(QString, data));
 }
 
 void WAConnection::sendGetGroups(const QString &type)
 {
-    d_ptr->sendGetGroups(type);
+    QMetaObject::invokeMethod(d_ptr, "sendGetGroups", Q_ARG(QString, type));
 }
 
 void WAConnection::sendGetBroadcasts()
 {
-    d_ptr->sendGetBroadcasts();
+    QMetaObject::invokeMethod(d_ptr, "sendGetBroadcasts");
 }
 
 void WAConnection::sendSubscribe(const QString &jid)
 {
-    d_ptr->sendPresenceRequest(jid, QString("subscribe"));
+    QMetaObject::invokeMethod(d_ptr, "sendPresenceRequest",
+                              Q_ARG(QString, jid), Q_ARG(QString, QString("subscribe")));
 }
 
 void WAConnection::sendUnsubscribe(const QString &jid)
 {
-    d_ptr->sendPresenceRequest(jid, QString("unsubscribe"));
+    QMetaObject::invokeMethod(d_ptr, "sendPresenceRequest",
+                              Q_ARG(QString, jid), Q_ARG(QString, QString("unsubscribe")));
 }
 
 void WAConnection::sendGetLastSeen(const QString &jid)
 {
-    d_ptr->sendGetLastSeen(jid);
+    QMetaObject::invokeMethod(d_ptr, "sendGetLastSeen", Q_ARG(QString, jid));
 }
 
 void WAConnection::sendGetPicture(const QString &jid)
 {
-    d_ptr->sendGetPicture(jid);
+    QMetaObject::invokeMethod(d_ptr, "sendGetPicture", Q_ARG(QString, jid));
 }
 
 void WAConnection::sendGetPictureIds(const QStringList &jids)
 {
-    d_ptr->sendGetPictureIds(jids);
+    QMetaObject::invokeMethod(d_ptr, "sendGetPictureIds", Q_ARG(QStringList, jids));
 }
 
 void WAConnection::sendGetStatuses(const QStringList &jids)
 {
-    d_ptr->sendGetStatuses(jids);
+    QMetaObject::invokeMethod(d_ptr, "sendGetStatuses", Q_ARG(QStringList, jids));
 }
 
 void WAConnection::syncContacts(const QVariantMap &contacts)
 {
-    d_ptr->syncContacts(contacts);
+    QMetaObject::invokeMethod(d_ptr, "syncContacts", Q_ARG(QVariantMap, contacts));
 }
 
 void WAConnection::sendMessageRead(const QString &jid, const QString &msgId, const QString &participant)
 {
-    d_ptr->sendMessageRead(jid, msgId, participant);
+    QMetaObject::invokeMethod(d_ptr, "sendMessageRead",
+                              Q_ARG(QString, jid), Q_ARG(QString, msgId), Q_ARG(QString, participant));
 }
 
 void WAConnection::sendText(const QString &jid, const QString &text)
 {
-    d_ptr->sendText(jid, text);
+    QMetaObject::invokeMethod(d_ptr, "sendText", Q_ARG(QString, jid), Q_ARG(QString, text));
 }
 
 void WAConnection::sendBroadcastText(const QString &jid, const QString &text, const QStringList &jids)
 {
-    d_ptr->sendBroadcastText(jid, text, jids);
+    QMetaObject::invokeMethod(d_ptr, "sendBroadcastText",
+                              Q_ARG(QString, jid), Q_ARG(QString, text), Q_ARG(QStringList, jids));
 }
 
 int WAConnection::sendRequest(const ProtocolTreeNode &node)
 {
     return d_ptr->sendRequest(node);
 }
-
-int WAConnection::sendRequest(const ProtocolTreeNode &node, const char *member)
-{
-    return d_ptr->sendRequest(node, member);
-}
@@ -3,13 +3,18 @@
 
 #include <QObject>
 #include <QVariantMap>
+#include <QAtomicInt>
 #include <QSqlDatabase>
 
 #include "libwa.h"
 #include "protocoltreenode.h"
+#include "payloadsink.h"
+#include "stanzahandler.h"
+#include "receiptaggregator.h"
 
 #define WAConnectionStatic (WAConnection::instance())
 
+class QThread;
 class WAConnectionPrivate;
 class LIBWA_API WAConnection : public QObject
 {
@@ -17,8 +22,58 @@ class LIBWA_API WAConnection : public QObject
 public:
     explicit WAConnection(QObject *parent = 0);
     virtual ~WAConnection();
+    // Process wide connection for single account applications, see
+    // WAConnectionManager to run several accounts
     static WAConnection *GetInstance(QObject *parent = 0);
 
+    // Unless noted otherwise the settings below can be made before or after
+    // init(), and survive setNetworkThread(). Everything else needs init().
+
+    // Large node payloads (media thumbnails, vcards...) are handed to the
+    // sink instead of being copied into the received stanzas
+    void setPayloadSink(PayloadSink *sink, int threshold = PAYLOADSINK_DEFAULT_THRESHOLD);
+
+    // Incoming stanzas with this tag (and attribute, or attribute value, if
+    // given) are skipped without being decoded. Only dictionary strings can
+    // be filtered on; returns false otherwise.
+    bool addStanzaFilter(const QString &tag, const QString &attribute = QString(),
+                         const QString &value = QString());
+    void clearStanzaFilters();
+
+    // Incoming stanzas with this tag (and type attribute, if given) that
+    // the library doesn't handle are passed to handler. Handlers are tried
+    // in the order they were added.
+    void addStanzaHandler(StanzaHandler *handler, const QString &tag,
+                          const QString &type = QString());
+    void removeStanzaHandler(StanzaHandler *handler);
+
+    // Queues outgoing stanzas and writes them to the socket together when
+    // control returns to the event loop. Off by default.
+    void setWriteCoalescing(bool enabled);
+
+    // Delivery/read receipts sent within window msecs of each other are
+    // batched into one receipt per chat, and acks held back with them; a
+    // batch waits at most maxLatency msecs. window <= 0 turns it off (the
+    // default).
+    void setReceiptBatching(int window, int maxLatency = RECEIPTAGGREGATOR_DEFAULT_MAX_LATENCY);
+
+    // Runs the socket, the protocol and the axolotl store in an internal
+    // thread. The public slots are forwarded to it and the signals arrive
+    // queued in the receivers' threads; payload sinks are called from it.
+    // Must be set before init().
+    void setNetworkThreadEnabled(bool enabled);
+    bool isNetworkThreadEnabled() const;
+
+    // Same, in a thread owned by the caller. It must be running an event
+    // loop for as long as the connection exists. NULL runs the connection
+    // in the thread of this object again. Must be set before init().
+    void setNetworkThread(QThread *thread);
+    QThread *getNetworkThread() const;
+
+    // Name of the QSqlDatabase connection of the axolotl store, it must be
+    // unique for every account in the process. Must be set before init().
+    void setStoreConnectionName(const QString &name);
+
     enum ConnectionStatus {
         Disconnected,
         Connecting,
@@ -31,6 +86,7 @@ public slots:
     void init();
 
     int getConnectionStatus();
+    QVariantMap getStatistics();
 
     void login(const QVariantMap &loginData);
     void logout();
@@ -63,10 +119,15 @@ protected:
 
 private:
     Q_DECLARE_PRIVATE(WAConnection)
-    int sendRequest(const ProtocolTreeNode &node, const char *member);
+    Qt::ConnectionType blockingConnection() const;
+
     int sendRequest(const ProtocolTreeNode &node);
 
-    int m_connectionStatus;
+    // Written by the network thread, read by getConnectionStatus() from any
+    QAtomicInt m_connectionStatus;
+    QThread *m_networkThread;
+    bool m_ownsNetworkThread;
+    bool m_initialized;
 
 private slots:
 
@@ -10,17 +10,18 @@
 #include "waconnection.h"
 
 #include "protocoltreenode.h"
+#include "protocoltreenodeview.h"
 #include "bintreenodewriter.h"
 #include "bintreenodereader.h"
 #include "keystream.h"
 #include "watokendictionary.h"
+#include "replytable.h"
+#include "receiptaggregator.h"
 
 #include "axolotl/liteaxolotlstore.h"
 
 #include "../libaxolotl/sessioncipher.h"
 
-#define WAREPLY(a) #a
-
 #define AXOLOTL_DB_CONNECTION "qt_sql_axolotl_connection"
 
 class WAConnectionPrivate : public QObject
@@ -29,42 +30,80 @@ class WAConnectionPrivate : public QObject
 public:
     explicit WAConnectionPrivate(WAConnection *q);
 
-    void login(const QVariantMap &loginData);
-    void logout();
-    void reconnect();
-    void sendGetProperties();
-    void sendPing();
-    void sendGetLastSeen(const QString &jid);
-    void sendGetStatuses(const QStringList &jids);
-    void sendGetPicture(const QString &jid);
-    void sendGetPictureIds(const QStringList &jids);
-    void sendPresenceRequest(const QString &jid, const QString &type);
-    void sendGetPrivacyList();
-    void sendSetPrivacyList(const QStringList &blockedJids, const QStringList &spamJids = QStringList());
-    void sendGetPushConfig();
-
-    void sendSetPresence(bool available, const QString &pushname = QString());
-
-    void sendText(const QString &jid, const QString &text, const QString &msgId = QString());
-    void sendBroadcastText(const QString &jid, const QString &text, const QStringList &jids);
-    void sendMessageRead(const QString &jid, const QString &msgId, const QString &participant);
-    void sendRetryMessage(const QString &jid, const QString &msgId, const QString &data);
-
-    void syncContacts(const QVariantMap &contacts);
-
-    void sendSync(const QStringList &syncContacts, const QStringList &deleteJids, int syncType = 4, int index = 0, bool last = true);
-    void sendGetFeatures(const QStringList &jids);
-    void sendGetGroups(const QString &type);
-    void sendGetBroadcasts();
-
-    void sendSetStatusMessage(const QString &message);
-
-    void sendTyping(const QString &jid, bool typing);
-
-    void getEncryptionStatus(const QString &jid);
+    // WAConnection calls these through QMetaObject::invokeMethod(), so they
+    // run in the thread that owns the connection (see setNetworkThreadEnabled()).
+    // Only the settings below can be used before init().
+    Q_INVOKABLE void login(const QVariantMap &loginData);
+    Q_INVOKABLE void logout();
+    Q_INVOKABLE void reconnect();
+    Q_INVOKABLE void sendGetProperties();
+    Q_INVOKABLE void sendPing();
+    Q_INVOKABLE void sendGetLastSeen(const QString &jid);
+    Q_INVOKABLE void sendGetStatuses(const QStringList &jids);
+    Q_INVOKABLE void sendGetPicture(const QString &jid);
+    Q_INVOKABLE void sendGetPictureIds(const QStringList &jids);
+    Q_INVOKABLE void sendPresenceRequest(const QString &jid, const QString &type);
+    Q_INVOKABLE void sendGetPrivacyList();
+    Q_INVOKABLE void sendSetPrivacyList(const QStringList &blockedJids, const QStringList &spamJids = QStringList());
+    Q_INVOKABLE void sendGetPushConfig();
+
+    Q_INVOKABLE void sendSetPresence(bool available, const QString &pushname = QString());
+
+    Q_INVOKABLE void sendText(const QString &jid, const QString &text, const QString &msgId = QString());
+    Q_INVOKABLE void sendBroadcastText(const QString &jid, const QString &text, const QStringList &jids);
+    Q_INVOKABLE void sendMessageRead(const QString &jid, const QString &msgId, const QString &participant);
+    Q_INVOKABLE void sendRetryMessage(const QString &jid, const QString &msgId, const QString &data);
+
+    Q_INVOKABLE void syncContacts(const QVariantMap &contacts);
+
+    Q_INVOKABLE void sendSync(const QStringList &syncContacts, const QStringList &deleteJids, int syncType = 4, int index = 0, bool last = true);
+    Q_INVOKABLE void sendGetFeatures(const QStringList &jids);
+    Q_INVOKABLE void sendGetGroups(const QString &type);
+    Q_INVOKABLE void sendGetBroadcasts();
+
+    Q_INVOKABLE void sendSetStatusMessage(const QString &message);
+
+    Q_INVOKABLE void sendTyping(const QString &jid, bool typing);
+
+    Q_INVOKABLE void getEncryptionStatus(const QString &jid);
+
+    Q_INVOKABLE QVariantMap getStatistics();
+    Q_INVOKABLE void setPayloadSink(PayloadSink *sink, int threshold);
+    Q_INVOKABLE bool addStanzaFilter(const QString &tag, const QString &attribute, const QString &value);
+    Q_INVOKABLE void clearStanzaFilters();
+    Q_INVOKABLE void addStanzaHandler(StanzaHandler *handler, const QString &tag, const QString &type);
+    Q_INVOKABLE void removeStanzaHandler(StanzaHandler *handler);
+    Q_INVOKABLE void setWriteCoalescing(bool enabled);
+    Q_INVOKABLE void setReceiptBatching(int window, int maxLatency);
+    Q_INVOKABLE void setStoreConnectionName(const QString &name);
+
+    // Takes over the settings of a private object that was never
+    // initialized, see WAConnection::setNetworkThread()
+    void copySettings(const WAConnectionPrivate *other);
+
+    // Requests expecting a reply, indexes replyHandlers
+    enum ReplyType {
+        ReplyServerProperties,
+        ReplyPong,
+        ReplyLastSeen,
+        ReplyStatuses,
+        ReplyPicture,
+        ReplyPictureIds,
+        ReplyPrivacyList,
+        ReplyPushConfig,
+        ReplyMessageSent,
+        ReplySync,
+        ReplyFeatures,
+        ReplyGroups,
+        ReplyBroadcasts,
+        ReplyPassive,
+        ReplyEncrypt,
+        ReplyGetKeys,
+        ReplyTypeCount
+    };
 
     int sendRequest(const ProtocolTreeNode &node);
-    int sendRequest(const ProtocolTreeNode &node, const char *member);
+    int sendRequest(const ProtocolTreeNode &node, ReplyType reply);
 
 public slots:
     void connectionServerProperties(const ProtocolTreeNode &node);
@@ -89,6 +128,22 @@ private:
     WAConnection * const q_ptr;
     QSharedPointer<LiteAxolotlStore> axolotlStore;
 
+    // Settings, kept here so they can be made before init() creates the
+    // objects they apply to
+    struct StanzaFilterTokens {
+        int tag;
+        int attribute;
+        int value;
+    };
+    QString m_storeConnection;
+    PayloadSink *m_payloadSink;
+    int m_payloadThreshold;
+    QList<StanzaFilterTokens> m_stanzaFilters;
+    bool m_writeCoalescing;
+    int m_receiptWindow;
+    int m_receiptMaxLatency;
+
+    void setConnectionStatus(int status);
     void tryLogin();
     int sendFeatures();
     int sendAuth();
@@ -102,8 +157,8 @@ private:
     void parseEncryptNotification(const ProtocolTreeNode &node);
     void parseReceipt(const ProtocolTreeNode &node);
     void parseReceiptList(const ProtocolTreeNode &node);
-    void parsePresence(const ProtocolTreeNode &node);
-    void parseChatstate(const ProtocolTreeNode &node);
+    void parsePresence(const ProtocolTreeNodeView &node);
+    void parseChatstate(const ProtocolTreeNodeView &node);
     void parseCall(const ProtocolTreeNode &node);
 
     QString makeId();
@@ -138,13 +193,38 @@ private:
     qulonglong getRecepient(const QString &jid);
 
     bool read();
+    bool dispatchStanza(const ProtocolTreeNodeView &view, const QString &id);
+    bool dispatchToHandlers(const ProtocolTreeNodeView &view);
+    bool parseIb(const ProtocolTreeNodeView &view);
+
+    struct StanzaHandlerEntry {
+        int tag;                // token ids, -1 if not in the dictionary
+        int type;
+        QByteArray tagName;
+        QString typeName;       // empty matches any type
+        StanzaHandler *handler;
+    };
+    QList<StanzaHandlerEntry> stanzaHandlers;
 
     bool m_isReading;
     bool m_authFailed;
 
     QReadWriteLock lockSeq;
 
-    QHash<QString, const char*> m_bindStore;
+    typedef void (WAConnectionPrivate::*ReplyHandler)(const ProtocolTreeNode &node);
+    typedef void (WAConnectionPrivate::*ExpiryHandler)(const QString &id);
+
+    struct ReplyInfo {
+        const char *name;
+        ReplyHandler handler;
+        ExpiryHandler expired;  // NULL if the request is just dropped
+        int timeout;            // msecs
+    };
+    static const ReplyInfo replyHandlers[ReplyTypeCount];
+
+    ReplyTable *replies;
+    ReceiptAggregator *receipts;
+    void pingExpired(const QString &id);
 
     QTcpSocket *socket;
     QAbstractSocket::SocketError socketLastError;
@@ -188,9 +268,11 @@ private:
 
 private slots:
     void init();
+    void dispose();
     void loginInternal();
 
     void readNode();
+    void replyExpired(const QString &id, int type);
 
     void socketConnected();
     void socketDisconnected();
@@ -0,0 +1,85 @@
+#include "waconnectionmanager.h"
+#include "waconnection_p.h"
+
+#include <QThread>
+
+WAConnectionManager::WAConnectionManager(int threads, QObject *parent) :
+    QObject(parent)
+{
+    if (threads <= 0)
+        threads = qMax(QThread::idealThreadCount(), 1);
+
+    for (int i = 0; i < threads; i++) {
+        QThread *thread = new QThread(this);
+        thread->start();
+        m_threads.append(thread);
+    }
+    m_threadLoad.fill(0, threads);
+}
+
+WAConnectionManager::~WAConnectionManager()
+{
+    // Connections go first, their private objects are disposed of in the
+    // worker threads
+    qDeleteAll(m_connections);
+    m_connections.clear();
+
+    foreach (QThread *thread, m_threads) {
+        thread->quit();
+        thread->wait();
+    }
+}
+
+WAConnection *WAConnectionManager::addConnection(const QString &account)
+{
+    WAConnection *connection = m_connections.value(account);
+    if (connection)
+        return connection;
+
+    int thread = 0;
+    for (int i = 1; i < m_threadLoad.size(); i++) {
+        if (m_threadLoad.at(i) < m_threadLoad.at(thread))
+            thread = i;
+    }
+
+    connection = new WAConnection(this);
+    connection->setStoreConnectionName(QString("%1_%2").arg(AXOLOTL_DB_CONNECTION).arg(account));
+    connection->setNetworkThread(m_threads.at(thread));
+    connection->init();
+
+    m_connections.insert(account, connection);
+    m_connectionThreads.insert(connection, thread);
+    m_threadLoad[thread]++;
+
+    return connection;
+}
+
+void WAConnectionManager::removeConnection(const QString &account)
+{
+    WAConnection *connection = m_connections.take(account);
+    if (!connection)
+        return;
+
+    m_threadLoad[m_connectionThreads.take(connection)]--;
+    delete connection;
+}
+
+WAConnection *WAConnectionManager::getConnection(const QString &account) const
+{
+    return m_connections.value(account);
+}
+
+QStringList WAConnectionManager::getAccounts() const
+{
+    return m_connections.keys();
+}
+
+int WAConnectionManager::getConnectionCount() const
+{
+    return m_connections.size();
+}
+
+int WAConnectionManager::getThreadCount() const
+{
+    return m_threads.size();
+}
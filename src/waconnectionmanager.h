@@ -0,0 +1,46 @@
+#ifndef WACONNECTIONMANAGER_H
+#define WACONNECTIONMANAGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+
+#include "libwa_global.h"
+#include "waconnection.h"
+
+class QThread;
+
+// Runs many accounts in one process. Every connection gets its own axolotl
+// store connection and is assigned to the least loaded of a fixed pool of
+// worker threads, each running its own event loop. The WAConnection objects
+// themselves live in the manager's thread: their slots are forwarded to the
+// worker and their signals arrive queued, as with
+// WAConnection::setNetworkThread().
+class LIBWA_API WAConnectionManager : public QObject
+{
+    Q_OBJECT
+public:
+    // threads == 0 starts one worker per CPU core
+    explicit WAConnectionManager(int threads = 0, QObject *parent = 0);
+    virtual ~WAConnectionManager();
+
+    // Creates and initializes the connection for account (the login used
+    // in WAConnection::login()), or returns the existing one
+    WAConnection *addConnection(const QString &account);
+    void removeConnection(const QString &account);
+
+    WAConnection *getConnection(const QString &account) const;
+    QStringList getAccounts() const;
+    int getConnectionCount() const;
+    int getThreadCount() const;
+
+private:
+    QList<QThread*> m_threads;
+    QVector<int> m_threadLoad;
+    QHash<QString, WAConnection*> m_connections;
+    QHash<WAConnection*, int> m_connectionThreads;
+};
+
+#endif // WACONNECTIONMANAGER_H
@@ -0,0 +1,51 @@
+#include "walog.h"
+
+#include <stdlib.h>
+
+static int initialLevel()
+{
+    const char *env = getenv("LIBWA_LOG_LEVEL");
+    if (!env)
+        return WALogInfo;
+    return qBound((int) WALogNone, atoi(env), (int) WALogDebug);
+}
+
+// Filled while the library is loaded rather than on first use, which
+// several network threads could race on
+static int levels[WALogCategoryCount];
+
+static int initLevels()
+{
+    int level = initialLevel();
+    for (int i = 0; i < WALogCategoryCount; i++)
+        levels[i] = level;
+    return 0;
+}
+Q_CONSTRUCTOR_FUNCTION(initLevels)
+
+static int dumpLimit = WALOG_DEFAULT_DUMP_LIMIT;
+
+bool WALog::isEnabled(int category, int level)
+{
+    return level <= levels[category];
+}
+
+void WALog::setLevel(int category, int level)
+{
+    levels[category] = level;
+}
+
+int WALog::getLevel(int category)
+{
+    return levels[category];
+}
+
+void WALog::setDumpLimit(int bytes)
+{
+    dumpLimit = bytes;
+}
+
+int WALog::getDumpLimit()
+{
+    return dumpLimit;
+}
@@ -0,0 +1,48 @@
+#ifndef WALOG_H
+#define WALOG_H
+
+#include <QDebug>
+
+#define WALOG_DEFAULT_DUMP_LIMIT    256
+
+enum WALogCategory {
+    WALogProtocol,      // stanza dumps
+    WALogNetwork,       // socket and frame errors
+    WALogConnection,    // connection state, login and reconnects
+    WALogCategoryCount
+};
+
+enum WALogLevel {
+    WALogNone,
+    WALogError,
+    WALogWarning,
+    WALogInfo,
+    WALogDebug
+};
+
+// Runtime log levels per category. The initial level of every category
+// can be set with the LIBWA_LOG_LEVEL environment variable (0-4), the
+// default is WALogInfo, so stanza dumps are off. The setters are meant
+// for setup, before the connections start.
+class WALog
+{
+public:
+    static bool isEnabled(int category, int level);
+    static void setLevel(int category, int level);
+    static int getLevel(int category);
+
+    // Maximum number of data bytes dumped per node, -1 for no limit
+    static void setDumpLimit(int bytes);
+    static int getDumpLimit();
+};
+
+// Use as WA_LOG(WALogProtocol, WALogDebug) << node.toString(). Nothing
+// after the macro is evaluated unless the category is enabled, and the
+// whole statement is compiled out when LIBWA_NO_LOG is defined.
+#ifdef LIBWA_NO_LOG
+#define WA_LOG(category, level) if (true) {} else qDebug()
+#else
+#define WA_LOG(category, level) if (!WALog::isEnabled(category, level)) {} else qDebug()
+#endif
+
+#endif // WALOG_H
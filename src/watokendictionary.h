@@ -1,9 +1,18 @@
 #ifndef WATOKENDICTIONARY_H
 #define WATOKENDICTIONARY_H
 
+#include <QByteArray>
 #include <QStringList>
 
-class WATokenDictionary : public QObject
+#include "watokenids.h"
+
+#define WATOKEN_PRIMARY_COUNT   236
+#define WATOKEN_SECONDARY_COUNT 224
+#define WATOKEN_COUNT           (WATOKEN_PRIMARY_COUNT + WATOKEN_SECONDARY_COUNT)
+
+// The Token enum (TokenXxx ids) comes from WATokenIds, generated with the
+// tables by tools/gentokens.py
+class WATokenDictionary : public QObject, public WATokenIds
 {
     Q_OBJECT
 public:
@@ -15,9 +24,14 @@ public:
     int primarySize() const;
     int secondarySize() const;
 
-private:
-    QStringList primaryStrings;
-    QStringList secondaryStrings;
+    // Id of a wire token, -1 if it isn't in the dictionary
+    static int tokenId(int token, bool subdict);
+    static int tokenId(const QString &string);
+    static int tokenId(const QChar *string, int length);
+
+    // Shared, pre-built forms of a token id. Empty for invalid ids.
+    static const QString &tokenString(int id);
+    static const QByteArray &tokenBytes(int id);
 };
 
 #endif // WATOKENDICTIONARY_H
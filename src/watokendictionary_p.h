@@ -0,0 +1,261 @@
+// Generated by tools/gentokens.py from tools/watokens.txt, do not edit.
+
+#ifndef WATOKENDICTIONARY_P_H
+#define WATOKENDICTIONARY_P_H
+
+#include <QtGlobal>
+
+#define WATOKEN_MAX_LENGTH     37
+#define WATOKEN_HASH_SIZE      1024
+#define WATOKEN_HASH_BUCKETS   256
+
+// Token strings by token id, secondary tokens follow the primary ones
+static const char * const watokenStrings[] = {
+    "", "stream:start", "stream:close", "account",
+    "ack", "action", "active", "add",
+    "after", "all", "allow", "apple",
+    "auth", "author", "available", "bad-protocol",
+    "bad-request", "before", "body", "broadcast",
+    "cancel", "category", "challenge", "chat",
+    "clean", "code", "composing", "config",
+    "contacts", "count", "create", "creation",
+    "debug", "default", "delete", "delivery",
+    "delta", "deny", "digest", "dirty",
+    "duplicate", "elapsed", "enable", "encoding",
+    "error", "event", "expiration", "expired",
+    "fail", "failure", "false", "favorites",
+    "feature", "features", "feature-not-implemented", "field",
+    "first", "free", "from", "g.us",
+    "get", "google", "group", "groups",
+    "groups_v2", "http://etherx.jabber.org/streams", "http://jabber.org/protocol/chatstates", "ib",
+    "id", "image", "img", "index",
+    "internal-server-error", "ip", "iq", "item-not-found",
+    "item", "jabber:iq:last", "jabber:iq:privacy", "jabber:x:event",
+    "jid", "kind", "last", "leave",
+    "list", "max", "mechanism", "media",
+    "message_acks", "message", "method", "microsoft",
+    "missing", "modify", "mute", "name",
+    "nokia", "none", "not-acceptable", "not-allowed",
+    "not-authorized", "notification", "notify", "off",
+    "offline", "order", "owner", "owning",
+    "p_o", "p_t", "paid", "participant",
+    "participants", "participating", "paused", "picture",
+    "pin", "ping", "platform", "port",
+    "presence", "preview", "probe", "prop",
+    "props", "query", "raw", "read",
+    "readreceipts", "reason", "receipt", "relay",
+    "remote-server-timeout", "remove", "request", "required",
+    "resource-constraint", "resource", "response", "result",
+    "retry", "rim", "s_o", "s_t",
+    "s.us", "s.whatsapp.net", "seconds", "server-error",
+    "server", "service-unavailable", "set", "show",
+    "silent", "stat", "status", "stream:error",
+    "stream:features", "subject", "subscribe", "success",
+    "sync", "t", "text", "timeout",
+    "timestamp", "to", "true", "type",
+    "unavailable", "unsubscribe", "uri", "url",
+    "urn:ietf:params:xml:ns:xmpp-sasl", "urn:ietf:params:xml:ns:xmpp-stanzas", "urn:ietf:params:xml:ns:xmpp-streams", "urn:xmpp:ping",
+    "urn:xmpp:whatsapp:account", "urn:xmpp:whatsapp:dirty", "urn:xmpp:whatsapp:mms", "urn:xmpp:whatsapp:push",
+    "urn:xmpp:whatsapp", "user", "user-not-found", "value",
+    "version", "w:g", "w:p:r", "w:p",
+    "w:profile:picture", "w", "wait", "WAUTH-2",
+    "xmlns:stream", "xmlns", "1", "chatstate",
+    "crypto", "phash", "enc", "class",
+    "off_cnt", "w:g2", "promote", "demote",
+    "creator", "Bell.caf", "Boing.caf", "Glass.caf",
+    "Harp.caf", "TimePassing.caf", "Tri-tone.caf", "Xylophone.caf",
+    "background", "backoff", "chunked", "context",
+    "full", "in", "interactive", "out",
+    "registration", "sid", "urn:xmpp:whatsapp:sync", "flt",
+    "s16", "u8", "adpcm", "amrnb",
+    "amrwb", "mp3", "pcm", "qcelp",
+    "wma", "h263", "h264", "jpeg",
+    "mpeg4", "wmv", "audio/3gpp", "audio/aac",
+    "audio/amr", "audio/mp4", "audio/mpeg", "audio/ogg",
+    "audio/qcelp", "audio/wav", "audio/webm", "audio/x-caf",
+    "audio/x-ms-wma", "image/gif", "image/jpeg", "image/png",
+    "video/3gpp", "video/avi", "video/mp4", "video/mpeg",
+    "video/quicktime", "video/x-flv", "video/x-ms-asf", "302",
+    "400", "401", "402", "403",
+    "404", "405", "406", "407",
+    "409", "410", "500", "501",
+    "503", "504", "abitrate", "acodec",
+    "app_uptime", "asampfmt", "asampfreq", "audio",
+    "clear", "conflict", "conn_no_nna", "cost",
+    "currency", "duration", "extend", "file",
+    "fps", "g_notify", "g_sound", "gcm",
+    "gone", "google_play", "hash", "height",
+    "invalid", "jid-malformed", "latitude", "lc",
+    "lg", "live", "location", "log",
+    "longitude", "max_groups", "max_participants", "max_subject",
+    "mimetype", "mode", "napi_version", "normalize",
+    "orighash", "origin", "passive", "password",
+    "played", "policy-violation", "pop_mean_time", "pop_plus_minus",
+    "price", "pricing", "redeem", "Replaced by new connection",
+    "resume", "signature", "size", "sound",
+    "source", "system-shutdown", "username", "vbitrate",
+    "vcard", "vcodec", "video", "width",
+    "xml-not-well-formed", "checkmarks", "image_max_edge", "image_max_kbytes",
+    "image_quality", "ka", "ka_grow", "ka_shrink",
+    "newmedia", "library", "caption", "forward",
+    "c0", "c1", "c2", "c3",
+    "clock_skew", "cts", "k0", "k1",
+    "login_rtt", "m_id", "nna_msg_rtt", "nna_no_off_count",
+    "nna_offline_ratio", "nna_push_rtt", "no_nna_con_count", "off_msg_rtt",
+    "on_msg_rtt", "stat_name", "sts", "suspect_conn",
+    "lists", "self", "qr", "web",
+    "w:b", "recipient", "w:stats", "forbidden",
+    "aurora.m4r", "bamboo.m4r", "chord.m4r", "circles.m4r",
+    "complete.m4r", "hello.m4r", "input.m4r", "keys.m4r",
+    "note.m4r", "popcorn.m4r", "pulse.m4r", "synth.m4r",
+    "filehash", "max_list_recipients", "en-AU", "en-GB",
+    "es-MX", "pt-PT", "zh-Hans", "zh-Hant",
+    "relayelection", "relaylatency", "interruption", "Apex.m4r",
+    "Beacon.m4r", "Bulletin.m4r", "By The Seaside.m4r", "Chimes.m4r",
+    "Circuit.m4r", "Constellation.m4r", "Cosmic.m4r", "Crystals.m4r",
+    "Hillside.m4r", "Illuminate.m4r", "Night Owl.m4r", "Opening.m4r",
+    "Playtime.m4r", "Presto.m4r", "Radar.m4r", "Radiate.m4r",
+    "Ripples.m4r", "Sencha.m4r", "Signal.m4r", "Silk.m4r",
+    "Slow Rise.m4r", "Stargaze.m4r", "Summit.m4r", "Twinkle.m4r",
+    "Uplift.m4r", "Waves.m4r", "voip", "eligible",
+    "upgrade", "planned", "current", "future",
+    "disable", "expire", "start", "stop",
+    "accuracy", "speed", "bearing", "recording",
+    "encrypt", "key", "identity", "w:gp2",
+    "admin", "locked", "unlocked", "new",
+    "battery", "archive", "adm", "plaintext_size",
+    "compressed_size", "delivered", "msg", "pkmsg",
+    "everyone", "v", "transport", "call-id"
+};
+
+static const unsigned char watokenLengths[] = {
+    0, 12, 12, 7, 3, 6, 6, 3, 5, 3, 5, 5, 4, 6, 9, 12,
+    11, 6, 4, 9, 6, 8, 9, 4, 5, 4, 9, 6, 8, 5, 6, 8,
+    5, 7, 6, 8, 5, 4, 6, 5, 9, 7, 6, 8, 5, 5, 10, 7,
+    4, 7, 5, 9, 7, 8, 23, 5, 5, 4, 4, 4, 3, 6, 5, 6,
+    9, 32, 37, 2, 2, 5, 3, 5, 21, 2, 2, 14, 4, 14, 17, 14,
+    3, 4, 4, 5, 4, 3, 9, 5, 12, 7, 6, 9, 7, 6, 4, 4,
+    5, 4, 14, 11, 14, 12, 6, 3, 7, 5, 5, 6, 3, 3, 4, 11,
+    12, 13, 6, 7, 3, 4, 8, 4, 8, 7, 5, 4, 5, 5, 3, 4,
+    12, 6, 7, 5, 21, 6, 7, 8, 19, 8, 8, 6, 5, 3, 3, 3,
+    4, 14, 7, 12, 6, 19, 3, 4, 6, 4, 6, 12, 15, 7, 9, 7,
+    4, 1, 4, 7, 9, 2, 4, 4, 11, 11, 3, 3, 32, 35, 35, 13,
+    25, 23, 21, 22, 17, 4, 14, 5, 7, 3, 5, 3, 17, 1, 4, 7,
+    12, 5, 1, 9, 6, 5, 3, 5, 7, 4, 7, 6, 7, 8, 9, 9,
+    8, 15, 12, 13, 10, 7, 7, 7, 4, 2, 11, 3, 12, 3, 22, 3,
+    3, 2, 5, 5, 5, 3, 3, 5, 3, 4, 4, 4, 5, 3, 10, 9,
+    9, 9, 10, 9, 11, 9, 10, 11, 14, 9, 10, 9, 10, 9, 9, 10,
+    15, 11, 14, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 8, 6, 10, 8, 9, 5, 5, 8, 11, 4, 8, 8, 6, 4,
+    3, 8, 7, 3, 4, 11, 4, 6, 7, 13, 8, 2, 2, 4, 8, 3,
+    9, 10, 16, 11, 8, 4, 12, 9, 8, 6, 7, 8, 6, 16, 13, 14,
+    5, 7, 6, 26, 6, 9, 4, 5, 6, 15, 8, 8, 5, 6, 5, 5,
+    19, 10, 14, 16, 13, 2, 7, 9, 8, 7, 7, 7, 2, 2, 2, 2,
+    10, 3, 2, 2, 9, 4, 11, 16, 17, 12, 16, 11, 10, 9, 3, 12,
+    5, 4, 2, 3, 3, 9, 7, 9, 10, 10, 9, 11, 12, 9, 9, 8,
+    8, 11, 9, 9, 8, 19, 5, 5, 5, 5, 7, 7, 13, 12, 12, 8,
+    10, 12, 18, 10, 11, 17, 10, 12, 12, 14, 13, 11, 12, 10, 9, 11,
+    11, 10, 10, 8, 13, 12, 10, 11, 10, 9, 4, 8, 7, 7, 7, 6,
+    7, 6, 5, 4, 8, 5, 7, 9, 7, 3, 8, 5, 5, 6, 8, 3,
+    7, 7, 3, 14, 15, 9, 3, 5, 8, 1, 9, 7
+};
+
+// Per bucket seed of the second hash
+static const unsigned short watokenSeeds[WATOKEN_HASH_BUCKETS] = {
+    1, 1, 2, 2, 1, 1, 0, 1, 0, 1, 2, 1, 1, 1, 0, 3,
+    1, 2, 2, 2, 1, 0, 1, 1, 1, 1, 2, 1, 1, 0, 2, 2,
+    1, 1, 3, 1, 1, 3, 3, 1, 1, 1, 1, 1, 0, 4, 2, 2,
+    1, 2, 1, 3, 0, 0, 2, 0, 2, 4, 1, 3, 2, 1, 1, 3,
+    1, 2, 3, 1, 0, 1, 1, 2, 1, 1, 1, 1, 2, 2, 3, 2,
+    1, 2, 1, 0, 2, 2, 3, 2, 1, 0, 0, 0, 4, 1, 2, 3,
+    1, 0, 1, 2, 2, 1, 0, 1, 1, 1, 2, 2, 1, 1, 2, 3,
+    1, 1, 0, 1, 1, 1, 1, 1, 1, 2, 10, 1, 1, 0, 1, 0,
+    1, 1, 1, 4, 1, 1, 1, 1, 4, 2, 0, 0, 1, 1, 1, 3,
+    1, 1, 1, 4, 1, 5, 1, 1, 1, 3, 2, 1, 1, 2, 1, 1,
+    3, 1, 1, 2, 4, 1, 2, 0, 3, 0, 2, 1, 0, 1, 1, 1,
+    2, 2, 1, 1, 0, 1, 0, 3, 2, 1, 1, 1, 1, 0, 0, 1,
+    6, 4, 3, 0, 2, 3, 0, 1, 1, 1, 2, 2, 2, 0, 4, 1,
+    1, 1, 3, 1, 1, 0, 1, 0, 1, 1, 6, 1, 3, 1, 2, 3,
+    1, 0, 0, 1, 10, 2, 1, 1, 1, 0, 1, 2, 1, 1, 2, 1,
+    1, 2, 1, 2, 4, 2, 4, 0, 1, 1, 2, 1, 1, 1, 0, 6
+};
+
+// Token id in every hash slot, -1 for empty slots
+static const short watokenSlots[WATOKEN_HASH_SIZE] = {
+    -1, -1, -1, -1, 394, -1, -1, -1, -1, -1, 124, -1, -1, -1, 231, 445,
+    189, -1, -1, -1, 72, -1, -1, -1, -1, 338, -1, -1, 183, -1, -1, 178,
+    -1, -1, 344, -1, -1, -1, 243, 303, -1, 114, -1, 396, -1, 319, -1, 159,
+    -1, 12, -1, -1, 204, -1, -1, 259, -1, -1, -1, -1, 362, -1, 301, -1,
+    71, -1, -1, 261, 458, -1, -1, -1, 376, -1, -1, 382, -1, -1, 241, -1,
+    -1, 28, 85, -1, 308, -1, -1, -1, 4, 205, 450, -1, 284, 408, -1, 334,
+    -1, -1, -1, -1, -1, -1, 15, 80, -1, -1, 65, 373, -1, -1, 140, 67,
+    -1, 43, -1, 410, 347, -1, -1, -1, 234, 313, -1, 321, -1, -1, 127, 289,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 70, -1, 90, 8, -1,
+    353, -1, -1, 116, -1, 196, -1, -1, -1, 451, -1, 101, 79, 152, -1, -1,
+    -1, -1, -1, -1, 294, 220, 270, -1, -1, 208, 88, -1, -1, -1, 182, 194,
+    -1, 60, 414, 398, 200, -1, -1, 109, 210, -1, 177, -1, 349, -1, -1, 381,
+    -1, -1, 102, 32, -1, -1, 256, 247, -1, 161, -1, -1, 11, -1, -1, 397,
+    370, -1, 74, 293, 103, 255, -1, 226, 322, 222, -1, 229, -1, -1, -1, 19,
+    18, -1, 246, 407, -1, 157, -1, -1, 147, -1, -1, -1, 58, -1, -1, 316,
+    384, -1, -1, -1, 133, -1, -1, -1, -1, -1, 453, -1, 264, 31, -1, -1,
+    3, -1, 337, 106, 164, -1, -1, -1, -1, 427, -1, 239, 180, 223, -1, 311,
+    -1, 320, -1, 137, 443, 456, 299, -1, -1, -1, 151, 76, -1, 128, -1, 435,
+    309, 120, 221, -1, -1, -1, 268, 14, -1, -1, -1, -1, -1, 91, -1, -1,
+    33, -1, 419, 104, -1, -1, -1, 35, 257, -1, -1, -1, -1, -1, -1, -1,
+    366, -1, -1, -1, 332, 315, -1, -1, 25, 68, 379, 431, 430, 387, 94, -1,
+    454, 323, 253, -1, -1, -1, 97, 62, 129, -1, -1, 452, 324, -1, 278, -1,
+    -1, -1, 216, 26, -1, -1, -1, -1, 428, -1, 248, -1, -1, -1, 224, 437,
+    416, -1, 365, 100, -1, 350, -1, -1, -1, -1, 368, -1, 77, 355, 361, -1,
+    -1, -1, 132, 113, 298, -1, -1, -1, 314, -1, -1, 392, -1, -1, 281, -1,
+    -1, -1, 36, -1, 141, -1, 175, -1, 73, -1, -1, -1, -1, -1, -1, 98,
+    160, 378, 242, -1, -1, -1, 168, -1, -1, 335, -1, -1, -1, -1, -1, -1,
+    405, 5, -1, 254, -1, 267, -1, -1, 29, 207, 57, 444, 21, 238, -1, 7,
+    -1, 276, -1, 142, -1, -1, -1, 181, -1, -1, -1, -1, 375, 300, 154, -1,
+    -1, -1, 356, -1, 449, 209, 262, 50, -1, 228, 206, -1, 163, 185, -1, -1,
+    412, 312, 340, -1, -1, -1, -1, -1, 250, -1, -1, -1, -1, 135, 282, 179,
+    302, -1, 364, -1, -1, -1, -1, -1, -1, -1, -1, 187, 455, -1, 442, 95,
+    -1, -1, 235, 245, 92, -1, 83, 296, -1, -1, 1, -1, 290, 24, -1, -1,
+    -1, 310, 155, -1, 341, 307, -1, -1, -1, -1, 385, -1, -1, 144, -1, -1,
+    125, 148, 75, -1, 343, 352, 20, -1, -1, -1, -1, 297, -1, -1, 89, 269,
+    -1, -1, -1, 188, 317, -1, -1, 176, 53, 433, 329, 327, -1, 139, 325, -1,
+    -1, 446, 9, -1, 41, -1, 136, 126, 274, -1, 359, 420, -1, 295, 336, 348,
+    -1, -1, -1, -1, -1, 425, 112, -1, -1, -1, 145, 166, -1, 214, -1, 49,
+    -1, 448, -1, -1, 82, -1, 374, 447, 436, -1, 86, -1, 258, -1, 272, -1,
+    -1, 395, -1, -1, -1, -1, -1, 266, -1, -1, -1, -1, 105, 123, -1, -1,
+    -1, 328, -1, -1, -1, 203, -1, -1, -1, -1, -1, -1, 227, -1, 236, 265,
+    -1, -1, -1, -1, -1, 251, 386, 280, 263, -1, 421, -1, 51, 134, -1, 167,
+    -1, 218, 404, -1, -1, 40, -1, -1, 390, -1, -1, 212, 286, 440, -1, 34,
+    260, -1, -1, -1, 138, -1, 367, -1, 172, -1, -1, 217, -1, 402, 143, 93,
+    119, 46, 27, 16, 330, -1, 153, -1, -1, -1, -1, -1, -1, 78, 2, -1,
+    -1, 121, 403, -1, 275, -1, 197, -1, -1, -1, 195, 413, 192, 150, 170, 411,
+    -1, -1, 108, 122, -1, 459, -1, -1, -1, 409, -1, 201, -1, -1, -1, 345,
+    149, -1, -1, 292, -1, 22, -1, -1, -1, 288, 59, 400, 45, -1, 283, -1,
+    -1, 225, -1, 56, -1, -1, -1, -1, 202, -1, 42, -1, 39, -1, -1, -1,
+    326, 13, 244, 162, -1, 199, 438, 318, -1, 87, -1, -1, 354, -1, -1, 115,
+    171, -1, -1, -1, 174, -1, 96, 273, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 357, -1, 377, -1, -1, 457, 232, -1, -1, -1, -1, 380, 339, -1, -1,
+    -1, 306, -1, 304, 389, 388, 434, -1, 271, -1, -1, -1, -1, -1, -1, -1,
+    30, -1, 371, 415, -1, 156, 369, 211, -1, 291, -1, -1, 69, -1, 363, 360,
+    279, -1, 23, 173, -1, -1, -1, -1, -1, 158, 219, 117, 84, -1, 342, -1,
+    -1, -1, 426, 186, 358, -1, -1, -1, 184, -1, 111, 333, 38, -1, -1, -1,
+    417, 331, -1, 61, 401, 47, -1, -1, -1, 432, -1, -1, 233, 64, -1, -1,
+    -1, -1, 287, -1, -1, 277, 193, 44, 55, 6, -1, -1, -1, -1, -1, 17,
+    66, 191, -1, 441, -1, -1, 54, -1, -1, -1, 249, 424, 63, -1, 37, -1,
+    -1, -1, -1, 383, -1, -1, 81, 305, -1, 169, 237, 391, 399, 406, -1, 423,
+    230, 198, 52, -1, 107, -1, -1, 215, 130, -1, 110, 190, -1, -1, -1, -1,
+    -1, 213, -1, -1, -1, -1, -1, 118, 48, 240, 429, 393, -1, -1, -1, 131,
+    -1, -1, 351, 418, -1, 10, 346, -1, -1, -1, 252, -1, 285, 165, -1, 439,
+    -1, 372, -1, -1, 422, -1, -1, -1, 99, 146, -1, -1, -1, -1, -1, -1
+};
+
+static inline quint32 watokenHash(quint32 seed, const ushort *string, int length)
+{
+    quint32 h = 2166136261u ^ seed;
+    for (int i = 0; i < length; i++) {
+        h ^= string[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+#endif // WATOKENDICTIONARY_P_H
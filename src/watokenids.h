@@ -0,0 +1,474 @@
+// Generated by tools/gentokens.py from tools/watokens.txt, do not edit.
+
+#ifndef WATOKENIDS_H
+#define WATOKENIDS_H
+
+// Token ids: primary tokens keep their index and secondary tokens
+// follow them, so every dictionary string has a single integer id.
+// WATokenDictionary inherits them as WATokenDictionary::TokenXxx.
+struct WATokenIds
+{
+    enum Token {
+        TokenStreamStart = 1,
+        TokenStreamClose = 2,
+        TokenAccount = 3,
+        TokenAck = 4,
+        TokenAction = 5,
+        TokenActive = 6,
+        TokenAdd = 7,
+        TokenAfter = 8,
+        TokenAll = 9,
+        TokenAllow = 10,
+        TokenApple = 11,
+        TokenAuth = 12,
+        TokenAuthor = 13,
+        TokenAvailable = 14,
+        TokenBadProtocol = 15,
+        TokenBadRequest = 16,
+        TokenBefore = 17,
+        TokenBody = 18,
+        TokenBroadcast = 19,
+        TokenCancel = 20,
+        TokenCategory = 21,
+        TokenChallenge = 22,
+        TokenChat = 23,
+        TokenClean = 24,
+        TokenCode = 25,
+        TokenComposing = 26,
+        TokenConfig = 27,
+        TokenContacts = 28,
+        TokenCount = 29,
+        TokenCreate = 30,
+        TokenCreation = 31,
+        TokenDebug = 32,
+        TokenDefault = 33,
+        TokenDelete = 34,
+        TokenDelivery = 35,
+        TokenDelta = 36,
+        TokenDeny = 37,
+        TokenDigest = 38,
+        TokenDirty = 39,
+        TokenDuplicate = 40,
+        TokenElapsed = 41,
+        TokenEnable = 42,
+        TokenEncoding = 43,
+        TokenError = 44,
+        TokenEvent = 45,
+        TokenExpiration = 46,
+        TokenExpired = 47,
+        TokenFail = 48,
+        TokenFailure = 49,
+        TokenFalse = 50,
+        TokenFavorites = 51,
+        TokenFeature = 52,
+        TokenFeatures = 53,
+        TokenFeatureNotImplemented = 54,
+        TokenField = 55,
+        TokenFirst = 56,
+        TokenFree = 57,
+        TokenFrom = 58,
+        TokenGUs = 59,
+        TokenGet = 60,
+        TokenGoogle = 61,
+        TokenGroup = 62,
+        TokenGroups = 63,
+        TokenGroupsV2 = 64,
+        TokenHttpEtherxJabberOrgStreams = 65,
+        TokenHttpJabberOrgProtocolChatstates = 66,
+        TokenIb = 67,
+        TokenId = 68,
+        TokenImage = 69,
+        TokenImg = 70,
+        TokenIndex = 71,
+        TokenInternalServerError = 72,
+        TokenIp = 73,
+        TokenIq = 74,
+        TokenItemNotFound = 75,
+        TokenItem = 76,
+        TokenJabberIqLast = 77,
+        TokenJabberIqPrivacy = 78,
+        TokenJabberXEvent = 79,
+        TokenJid = 80,
+        TokenKind = 81,
+        TokenLast = 82,
+        TokenLeave = 83,
+        TokenList = 84,
+        TokenMax = 85,
+        TokenMechanism = 86,
+        TokenMedia = 87,
+        TokenMessageAcks = 88,
+        TokenMessage = 89,
+        TokenMethod = 90,
+        TokenMicrosoft = 91,
+        TokenMissing = 92,
+        TokenModify = 93,
+        TokenMute = 94,
+        TokenName = 95,
+        TokenNokia = 96,
+        TokenNone = 97,
+        TokenNotAcceptable = 98,
+        TokenNotAllowed = 99,
+        TokenNotAuthorized = 100,
+        TokenNotification = 101,
+        TokenNotify = 102,
+        TokenOff = 103,
+        TokenOffline = 104,
+        TokenOrder = 105,
+        TokenOwner = 106,
+        TokenOwning = 107,
+        TokenPO = 108,
+        TokenPT = 109,
+        TokenPaid = 110,
+        TokenParticipant = 111,
+        TokenParticipants = 112,
+        TokenParticipating = 113,
+        TokenPaused = 114,
+        TokenPicture = 115,
+        TokenPin = 116,
+        TokenPing = 117,
+        TokenPlatform = 118,
+        TokenPort = 119,
+        TokenPresence = 120,
+        TokenPreview = 121,
+        TokenProbe = 122,
+        TokenProp = 123,
+        TokenProps = 124,
+        TokenQuery = 125,
+        TokenRaw = 126,
+        TokenRead = 127,
+        TokenReadreceipts = 128,
+        TokenReason = 129,
+        TokenReceipt = 130,
+        TokenRelay = 131,
+        TokenRemoteServerTimeout = 132,
+        TokenRemove = 133,
+        TokenRequest = 134,
+        TokenRequired = 135,
+        TokenResourceConstraint = 136,
+        TokenResource = 137,
+        TokenResponse = 138,
+        TokenResult = 139,
+        TokenRetry = 140,
+        TokenRim = 141,
+        TokenSO = 142,
+        TokenST = 143,
+        TokenSUs = 144,
+        TokenSWhatsappNet = 145,
+        TokenSeconds = 146,
+        TokenServerError = 147,
+        TokenServer = 148,
+        TokenServiceUnavailable = 149,
+        TokenSet = 150,
+        TokenShow = 151,
+        TokenSilent = 152,
+        TokenStat = 153,
+        TokenStatus = 154,
+        TokenStreamError = 155,
+        TokenStreamFeatures = 156,
+        TokenSubject = 157,
+        TokenSubscribe = 158,
+        TokenSuccess = 159,
+        TokenSync = 160,
+        TokenT = 161,
+        TokenText = 162,
+        TokenTimeout = 163,
+        TokenTimestamp = 164,
+        TokenTo = 165,
+        TokenTrue = 166,
+        TokenType = 167,
+        TokenUnavailable = 168,
+        TokenUnsubscribe = 169,
+        TokenUri = 170,
+        TokenUrl = 171,
+        TokenUrnIetfParamsXmlNsXmppSasl = 172,
+        TokenUrnIetfParamsXmlNsXmppStanzas = 173,
+        TokenUrnIetfParamsXmlNsXmppStreams = 174,
+        TokenUrnXmppPing = 175,
+        TokenUrnXmppWhatsappAccount = 176,
+        TokenUrnXmppWhatsappDirty = 177,
+        TokenUrnXmppWhatsappMms = 178,
+        TokenUrnXmppWhatsappPush = 179,
+        TokenUrnXmppWhatsapp = 180,
+        TokenUser = 181,
+        TokenUserNotFound = 182,
+        TokenValue = 183,
+        TokenVersion = 184,
+        TokenWG = 185,
+        TokenWPR = 186,
+        TokenWP = 187,
+        TokenWProfilePicture = 188,
+        TokenW = 189,
+        TokenWait = 190,
+        TokenWAUTH2 = 191,
+        TokenXmlnsStream = 192,
+        TokenXmlns = 193,
+        Token1 = 194,
+        TokenChatstate = 195,
+        TokenCrypto = 196,
+        TokenPhash = 197,
+        TokenEnc = 198,
+        TokenClass = 199,
+        TokenOffCnt = 200,
+        TokenWG2 = 201,
+        TokenPromote = 202,
+        TokenDemote = 203,
+        TokenCreator = 204,
+        TokenBellCaf = 205,
+        TokenBoingCaf = 206,
+        TokenGlassCaf = 207,
+        TokenHarpCaf = 208,
+        TokenTimePassingCaf = 209,
+        TokenTriToneCaf = 210,
+        TokenXylophoneCaf = 211,
+        TokenBackground = 212,
+        TokenBackoff = 213,
+        TokenChunked = 214,
+        TokenContext = 215,
+        TokenFull = 216,
+        TokenIn = 217,
+        TokenInteractive = 218,
+        TokenOut = 219,
+        TokenRegistration = 220,
+        TokenSid = 221,
+        TokenUrnXmppWhatsappSync = 222,
+        TokenFlt = 223,
+        TokenS16 = 224,
+        TokenU8 = 225,
+        TokenAdpcm = 226,
+        TokenAmrnb = 227,
+        TokenAmrwb = 228,
+        TokenMp3 = 229,
+        TokenPcm = 230,
+        TokenQcelp = 231,
+        TokenWma = 232,
+        TokenH263 = 233,
+        TokenH264 = 234,
+        TokenJpeg = 235,
+        TokenMpeg4 = 236,
+        TokenWmv = 237,
+        TokenAudio3gpp = 238,
+        TokenAudioAac = 239,
+        TokenAudioAmr = 240,
+        TokenAudioMp4 = 241,
+        TokenAudioMpeg = 242,
+        TokenAudioOgg = 243,
+        TokenAudioQcelp = 244,
+        TokenAudioWav = 245,
+        TokenAudioWebm = 246,
+        TokenAudioXCaf = 247,
+        TokenAudioXMsWma = 248,
+        TokenImageGif = 249,
+        TokenImageJpeg = 250,
+        TokenImagePng = 251,
+        TokenVideo3gpp = 252,
+        TokenVideoAvi = 253,
+        TokenVideoMp4 = 254,
+        TokenVideoMpeg = 255,
+        TokenVideoQuicktime = 256,
+        TokenVideoXFlv = 257,
+        TokenVideoXMsAsf = 258,
+        Token302 = 259,
+        Token400 = 260,
+        Token401 = 261,
+        Token402 = 262,
+        Token403 = 263,
+        Token404 = 264,
+        Token405 = 265,
+        Token406 = 266,
+        Token407 = 267,
+        Token409 = 268,
+        Token410 = 269,
+        Token500 = 270,
+        Token501 = 271,
+        Token503 = 272,
+        Token504 = 273,
+        TokenAbitrate = 274,
+        TokenAcodec = 275,
+        TokenAppUptime = 276,
+        TokenAsampfmt = 277,
+        TokenAsampfreq = 278,
+        TokenAudio = 279,
+        TokenClear = 280,
+        TokenConflict = 281,
+        TokenConnNoNna = 282,
+        TokenCost = 283,
+        TokenCurrency = 284,
+        TokenDuration = 285,
+        TokenExtend = 286,
+        TokenFile = 287,
+        TokenFps = 288,
+        TokenGNotify = 289,
+        TokenGSound = 290,
+        TokenGcm = 291,
+        TokenGone = 292,
+        TokenGooglePlay = 293,
+        TokenHash = 294,
+        TokenHeight = 295,
+        TokenInvalid = 296,
+        TokenJidMalformed = 297,
+        TokenLatitude = 298,
+        TokenLc = 299,
+        TokenLg = 300,
+        TokenLive = 301,
+        TokenLocation = 302,
+        TokenLog = 303,
+        TokenLongitude = 304,
+        TokenMaxGroups = 305,
+        TokenMaxParticipants = 306,
+        TokenMaxSubject = 307,
+        TokenMimetype = 308,
+        TokenMode = 309,
+        TokenNapiVersion = 310,
+        TokenNormalize = 311,
+        TokenOrighash = 312,
+        TokenOrigin = 313,
+        TokenPassive = 314,
+        TokenPassword = 315,
+        TokenPlayed = 316,
+        TokenPolicyViolation = 317,
+        TokenPopMeanTime = 318,
+        TokenPopPlusMinus = 319,
+        TokenPrice = 320,
+        TokenPricing = 321,
+        TokenRedeem = 322,
+        TokenReplacedByNewConnection = 323,
+        TokenResume = 324,
+        TokenSignature = 325,
+        TokenSize = 326,
+        TokenSound = 327,
+        TokenSource = 328,
+        TokenSystemShutdown = 329,
+        TokenUsername = 330,
+        TokenVbitrate = 331,
+        TokenVcard = 332,
+        TokenVcodec = 333,
+        TokenVideo = 334,
+        TokenWidth = 335,
+        TokenXmlNotWellFormed = 336,
+        TokenCheckmarks = 337,
+        TokenImageMaxEdge = 338,
+        TokenImageMaxKbytes = 339,
+        TokenImageQuality = 340,
+        TokenKa = 341,
+        TokenKaGrow = 342,
+        TokenKaShrink = 343,
+        TokenNewmedia = 344,
+        TokenLibrary = 345,
+        TokenCaption = 346,
+        TokenForward = 347,
+        TokenC0 = 348,
+        TokenC1 = 349,
+        TokenC2 = 350,
+        TokenC3 = 351,
+        TokenClockSkew = 352,
+        TokenCts = 353,
+        TokenK0 = 354,
+        TokenK1 = 355,
+        TokenLoginRtt = 356,
+        TokenMId = 357,
+        TokenNnaMsgRtt = 358,
+        TokenNnaNoOffCount = 359,
+        TokenNnaOfflineRatio = 360,
+        TokenNnaPushRtt = 361,
+        TokenNoNnaConCount = 362,
+        TokenOffMsgRtt = 363,
+        TokenOnMsgRtt = 364,
+        TokenStatName = 365,
+        TokenSts = 366,
+        TokenSuspectConn = 367,
+        TokenLists = 368,
+        TokenSelf = 369,
+        TokenQr = 370,
+        TokenWeb = 371,
+        TokenWB = 372,
+        TokenRecipient = 373,
+        TokenWStats = 374,
+        TokenForbidden = 375,
+        TokenAuroraM4r = 376,
+        TokenBambooM4r = 377,
+        TokenChordM4r = 378,
+        TokenCirclesM4r = 379,
+        TokenCompleteM4r = 380,
+        TokenHelloM4r = 381,
+        TokenInputM4r = 382,
+        TokenKeysM4r = 383,
+        TokenNoteM4r = 384,
+        TokenPopcornM4r = 385,
+        TokenPulseM4r = 386,
+        TokenSynthM4r = 387,
+        TokenFilehash = 388,
+        TokenMaxListRecipients = 389,
+        TokenEnAU = 390,
+        TokenEnGB = 391,
+        TokenEsMX = 392,
+        TokenPtPT = 393,
+        TokenZhHans = 394,
+        TokenZhHant = 395,
+        TokenRelayelection = 396,
+        TokenRelaylatency = 397,
+        TokenInterruption = 398,
+        TokenApexM4r = 399,
+        TokenBeaconM4r = 400,
+        TokenBulletinM4r = 401,
+        TokenByTheSeasideM4r = 402,
+        TokenChimesM4r = 403,
+        TokenCircuitM4r = 404,
+        TokenConstellationM4r = 405,
+        TokenCosmicM4r = 406,
+        TokenCrystalsM4r = 407,
+        TokenHillsideM4r = 408,
+        TokenIlluminateM4r = 409,
+        TokenNightOwlM4r = 410,
+        TokenOpeningM4r = 411,
+        TokenPlaytimeM4r = 412,
+        TokenPrestoM4r = 413,
+        TokenRadarM4r = 414,
+        TokenRadiateM4r = 415,
+        TokenRipplesM4r = 416,
+        TokenSenchaM4r = 417,
+        TokenSignalM4r = 418,
+        TokenSilkM4r = 419,
+        TokenSlowRiseM4r = 420,
+        TokenStargazeM4r = 421,
+        TokenSummitM4r = 422,
+        TokenTwinkleM4r = 423,
+        TokenUpliftM4r = 424,
+        TokenWavesM4r = 425,
+        TokenVoip = 426,
+        TokenEligible = 427,
+        TokenUpgrade = 428,
+        TokenPlanned = 429,
+        TokenCurrent = 430,
+        TokenFuture = 431,
+        TokenDisable = 432,
+        TokenExpire = 433,
+        TokenStart = 434,
+        TokenStop = 435,
+        TokenAccuracy = 436,
+        TokenSpeed = 437,
+        TokenBearing = 438,
+        TokenRecording = 439,
+        TokenEncrypt = 440,
+        TokenKey = 441,
+        TokenIdentity = 442,
+        TokenWGp2 = 443,
+        TokenAdmin = 444,
+        TokenLocked = 445,
+        TokenUnlocked = 446,
+        TokenNew = 447,
+        TokenBattery = 448,
+        TokenArchive = 449,
+        TokenAdm = 450,
+        TokenPlaintextSize = 451,
+        TokenCompressedSize = 452,
+        TokenDelivered = 453,
+        TokenMsg = 454,
+        TokenPkmsg = 455,
+        TokenEveryone = 456,
+        TokenV = 457,
+        TokenTransport = 458,
+        TokenCallId = 459
+    };
+};
+
+#endif // WATOKENIDS_H
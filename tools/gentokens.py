@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+#
+# Generates from tools/watokens.txt:
+#  - src/watokendictionary_p.h: the token strings and lengths indexed by
+#    token id, plus a perfect hash (hash and displace) for string -> token
+#    id lookups
+#  - src/watokenids.h: the WATokenDictionary::Token enum, one TokenXxx per
+#    token ("stream:start" is TokenStreamStart)
+#
+# usage: tools/gentokens.py [watokens.txt] [watokendictionary_p.h] [watokenids.h]
+
+import os
+import re
+import sys
+
+PRIMARY_COUNT = 236
+SECONDARY_COUNT = 224
+
+HASH_SIZE = 1024    # slots, power of two
+HASH_BUCKETS = 256
+
+here = os.path.dirname(os.path.abspath(__file__))
+source = sys.argv[1] if len(sys.argv) > 1 else os.path.join(here, 'watokens.txt')
+target = sys.argv[2] if len(sys.argv) > 2 else os.path.join(here, '..', 'src', 'watokendictionary_p.h')
+ids_target = sys.argv[3] if len(sys.argv) > 3 else os.path.join(here, '..', 'src', 'watokenids.h')
+
+
+def read_tokens(path):
+    sections = {'primary': [''], 'secondary': []}
+    current = None
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if not line or line.startswith('#'):
+                continue
+            if line.startswith('[') and line.endswith(']'):
+                current = sections[line[1:-1]]
+                continue
+            current.append(line)
+    return sections['primary'], sections['secondary']
+
+
+# Must match watokenHash() in the generated header: FNV-1a over UTF-16 units
+def token_hash(seed, token):
+    h = 2166136261 ^ seed
+    for c in token:
+        h ^= ord(c)
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+
+def build_hash(tokens):
+    buckets = [[] for i in range(HASH_BUCKETS)]
+    for tid, token in enumerate(tokens):
+        if token:
+            buckets[token_hash(0, token) % HASH_BUCKETS].append(tid)
+
+    seeds = [0] * HASH_BUCKETS
+    slots = [-1] * HASH_SIZE
+    # Largest buckets first, they are the hardest to place
+    for b in sorted(range(HASH_BUCKETS), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        seed = 1
+        while True:
+            wanted = [token_hash(seed, tokens[tid]) & (HASH_SIZE - 1) for tid in buckets[b]]
+            if len(set(wanted)) == len(wanted) and all(slots[s] < 0 for s in wanted):
+                break
+            seed += 1
+        seeds[b] = seed
+        for tid, s in zip(buckets[b], wanted):
+            slots[s] = tid
+    return seeds, slots
+
+
+def c_string(token):
+    return '"' + token.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def table(values, per_line):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join(values[i:i + per_line]))
+    return ',\n'.join(lines)
+
+
+# "stream:start" -> "StreamStart", "w:gp2" -> "WGp2"
+def enum_name(token):
+    parts = re.split(r'[^A-Za-z0-9]+', token)
+    return 'Token' + ''.join(p[:1].upper() + p[1:] for p in parts if p)
+
+
+def write_ids(tokens, path):
+    names = {}
+    for tid, token in enumerate(tokens):
+        if not token:
+            continue
+        name = enum_name(token)
+        if name in names:
+            sys.exit('tokens %r and %r both map to %s'
+                     % (tokens[names[name]], token, name))
+        names[name] = tid
+
+    out = []
+    out.append('// Generated by tools/gentokens.py from tools/watokens.txt, do not edit.')
+    out.append('')
+    out.append('#ifndef WATOKENIDS_H')
+    out.append('#define WATOKENIDS_H')
+    out.append('')
+    out.append('// Token ids: primary tokens keep their index and secondary tokens')
+    out.append('// follow them, so every dictionary string has a single integer id.')
+    out.append('// WATokenDictionary inherits them as WATokenDictionary::TokenXxx.')
+    out.append('struct WATokenIds')
+    out.append('{')
+    out.append('    enum Token {')
+    entries = ['        %s = %d' % (name, tid) for name, tid in sorted(names.items(), key=lambda e: e[1])]
+    out.append(',\n'.join(entries))
+    out.append('    };')
+    out.append('};')
+    out.append('')
+    out.append('#endif // WATOKENIDS_H')
+
+    with open(path, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+def main():
+    primary, secondary = read_tokens(source)
+    if len(primary) != PRIMARY_COUNT or len(secondary) != SECONDARY_COUNT:
+        sys.exit('expected %d primary and %d secondary tokens, got %d and %d'
+                 % (PRIMARY_COUNT, SECONDARY_COUNT, len(primary), len(secondary)))
+
+    tokens = primary + secondary
+    if any(ord(c) > 0x7f for token in tokens for c in token):
+        sys.exit('tokens must be ASCII')
+    if len(set(tokens)) != len(tokens):
+        sys.exit('duplicate tokens')
+
+    seeds, slots = build_hash(tokens)
+
+    out = []
+    out.append('// Generated by tools/gentokens.py from tools/watokens.txt, do not edit.')
+    out.append('')
+    out.append('#ifndef WATOKENDICTIONARY_P_H')
+    out.append('#define WATOKENDICTIONARY_P_H')
+    out.append('')
+    out.append('#include <QtGlobal>')
+    out.append('')
+    out.append('#define WATOKEN_MAX_LENGTH     %d' % max(len(t) for t in tokens))
+    out.append('#define WATOKEN_HASH_SIZE      %d' % HASH_SIZE)
+    out.append('#define WATOKEN_HASH_BUCKETS   %d' % HASH_BUCKETS)
+    out.append('')
+    out.append('// Token strings by token id, secondary tokens follow the primary ones')
+    out.append('static const char * const watokenStrings[] = {')
+    out.append(table([c_string(t) for t in tokens], 4))
+    out.append('};')
+    out.append('')
+    out.append('static const unsigned char watokenLengths[] = {')
+    out.append(table([str(len(t)) for t in tokens], 16))
+    out.append('};')
+    out.append('')
+    out.append('// Per bucket seed of the second hash')
+    out.append('static const unsigned short watokenSeeds[WATOKEN_HASH_BUCKETS] = {')
+    out.append(table([str(s) for s in seeds], 16))
+    out.append('};')
+    out.append('')
+    out.append('// Token id in every hash slot, -1 for empty slots')
+    out.append('static const short watokenSlots[WATOKEN_HASH_SIZE] = {')
+    out.append(table([str(s) for s in slots], 16))
+    out.append('};')
+    out.append('')
+    out.append('static inline quint32 watokenHash(quint32 seed, const ushort *string, int length)')
+    out.append('{')
+    out.append('    quint32 h = 2166136261u ^ seed;')
+    out.append('    for (int i = 0; i < length; i++) {')
+    out.append('        h ^= string[i];')
+    out.append('        h *= 16777619u;')
+    out.append('    }')
+    out.append('    return h;')
+    out.append('}')
+    out.append('')
+    out.append('#endif // WATOKENDICTIONARY_P_H')
+
+    with open(target, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+    write_ids(tokens, ids_target)
+
+
+if __name__ == '__main__':
+    main()